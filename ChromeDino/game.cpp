@@ -7,9 +7,10 @@
 #include <unordered_set>
 #include <sstream>
 #include <cstdlib>
-#include <random>
 #include <cmath>
 #include <vector>
+#include <limits>
+#include <charconv>
 #include <SDL3/SDL.h>
 #include <NeneEngine/NeneNode.hpp>
 
@@ -25,23 +26,35 @@ protected:
         // 念のため必要なサービスが注入されているか確認する
         if (!asset_loader || !path_service || !blackboard) nnthrow("services not ready (asset_loader/path_service/blackboard)");
         if (!collision_world) nnthrow("services not ready (collision_world)");
-        // テクスチャ
-        sprite_tex_ = asset_loader->get_texture(path_service->resolve("assets/sprites/sprite.png"));
-        if (!sprite_tex_) nnthrow("failed to load dino sprite texture");
+        if (!animation) nnthrow("services not ready (animation)");
+        if (!input) nnthrow("services not ready (input)");
+        // ジャンプ（キーコンフィグは黒板の "input.jump"）
+        jump_action_ = input->action("jump", "Space,Up");
+        // スプライト（Game で登録済み）
+        const NeneSprite run0 = asset_loader->sprite("dino_run_0");
+        const NeneSprite run1 = asset_loader->sprite("dino_run_1");
+        jump_ = run0;
+        if (!run0.texture) nnthrow("failed to load dino sprite texture");
+        // 走りアニメーション（同じシートなので src だけ切り替える）
+        run_clip_ = animation->clips().id("dino_run");
+        if (run_clip_ == kNeneNoClip) {
+            NeneAnimClip clip;
+            clip.frames = { NeneAnimFrame{ run0.src, run_frame_sec_ }, NeneAnimFrame{ run1.src, run_frame_sec_ } };
+            run_clip_ = animation->clips().add_clip("dino_run", std::move(clip));
+        }
+        // 持ち主を渡しておくと, World の水門が閉じている間（ゲームオーバー中）は止まる
+        anim_id_ = animation->add(run_clip_, "", this);
         w_ = 88.0f;
         h_ = 96.0f;
         // 初期位置
         x_ = 120.0f;
         y_ = blackboard->ground_y - h_;
-        // 走りアニメ
-        run_src_[0] = SDL_FRect{ 1514.2f, 0.0f, 88.0f, 96.0f };
-        run_src_[1] = SDL_FRect{ 1602.2f, 0.0f, 88.0f, 96.0f };
-        jump_src_ = run_src_[0];
+        // コライダー可視化の切り替えは購読で受け取る
+        show_hitbox_sub_ = blackboard->subscribe<bool>(blackboard->key<bool>("show_hitbox"),
+            [this](const bool& v) { show_hitbox_ = v; });
         // 状態
         on_ground_ = true;
         vy_ = 0.0f;
-        anim_accum_ = 0.0f;
-        anim_idx_ = 0;
         dead_ = false;
         // CollisionWorld登録（恐竜の凸近似）
         NeneColorPolygon poly;
@@ -67,29 +80,46 @@ protected:
         poly.debug_alpha = 0.25f;
         // コライダー登録
         collider_id_ = collision_world->add_collider(std::move(poly));
-    }
-    // 外部イベント
-    void handle_sdl_event(const SDL_Event& ev) override {
+        // 着地の土ぼこり（粒は1つのノードにまとめて持つ）
+        auto dust = std::make_unique<NeneParticleEmitter>("dino_dust", 256);
+        NeneParticleEmitter::Params& dp = dust->params();
+        dp.spread = SDL_FPoint{ w_ * 0.3f, 0.0f };
+        dp.life_min = 0.25f;
+        dp.life_max = 0.45f;
+        dp.speed_min = 60.0f;
+        dp.speed_max = 160.0f;
+        dp.angle_min = 3.4f; // 上向き（左上〜右上）
+        dp.angle_max = 6.0f;
+        dp.gravity = SDL_FPoint{ 0.0f, 900.0f };
+        dp.size_start = 6.0f;
+        dp.size_end = 2.0f;
+        dp.color_start = SDL_FColor{ 0.33f, 0.33f, 0.33f, 0.9f };
+        dp.color_end = SDL_FColor{ 0.33f, 0.33f, 0.33f, 0.0f };
+        dust_ = dust.get();
+        add_child(std::move(dust));
+    }
+    // やり直し（コライダーはそのまま使う）
+    bool reset_node() override {
+        x_ = 120.0f;
+        y_ = blackboard->ground_y - h_;
+        on_ground_ = true;
+        vy_ = 0.0f;
+        dead_ = false;
+        if (dust_) dust_->clear();
+        animation->play(anim_id_, run_clip_, true);
+        update_anim_speed_();
+        if (collider_id_ != 0) set_collider_position(collider_id_, SDL_FPoint{ x_, y_ });
+        return true;
+    }
+    // 入力
+    void handle_input(const NeneInput& in) override {
         if (dead_) return;
-        // スペースキーでジャンプ
-        if (ev.type == SDL_EVENT_KEY_DOWN) {
-            if (ev.key.key == SDLK_SPACE || ev.key.key == SDLK_UP) {
-                try_jump_();
-            }
-        }
+        if (in.pressed(jump_action_)) try_jump_();
     }
     // タイムラプス
     void handle_time_lapse(const float& dt) override {
         if (!blackboard) return;
         if (dead_) return;
-        // 地上にいれば走るアニメーションを再生し続ける
-        if (on_ground_) {
-            anim_accum_ += dt;
-            if (anim_accum_ >= run_frame_sec_) {
-                anim_accum_ = 0.0f;
-                anim_idx_ = (anim_idx_ + 1) % 2;
-            }
-        }
         // ジャンプ中なら物理演算に従って座標を更新し続ける
         vy_ += blackboard->gravity * dt;
         y_  += vy_ * dt;
@@ -97,27 +127,37 @@ protected:
         if (y_ >= ground_y) {
             y_ = ground_y;
             vy_ = 0.0f;
+            if (!on_ground_ && dust_) {
+                dust_->set_position(SDL_FPoint{ x_ + w_ * 0.5f, y_ + h_ });
+                dust_->emit(24);
+            }
             on_ground_ = true;
         } else {
             on_ground_ = false;
         }
+        // 走るアニメーションは地上にいる間だけ進める
+        update_anim_speed_();
         // コライダーの位置も更新する
-        if (collision_world && collider_id_ != 0) {
-            collision_world->set_position(collider_id_, SDL_FPoint{ x_, y_ });
-        }
+        if (collider_id_ != 0) set_collider_position(collider_id_, SDL_FPoint{ x_, y_ });
+    }
+    // 描画範囲（カリング用）
+    bool render_bounds(SDL_FRect& out) const override {
+        out = SDL_FRect{ x_, y_, w_, h_ };
+        return true;
     }
     // レンダリング
     void render(SDL_Renderer* r) override {
         if (!r) return;
-        if (!sprite_tex_) return;
-        const SDL_FRect* src = (!on_ground_) ? &jump_src_ : &run_src_[anim_idx_];
-        SDL_FRect dst { x_, y_, w_, h_ };
-        SDL_RenderTexture(r, sprite_tex_, src, &dst);
+        if (!jump_.texture) return;
+        const SDL_FRect* src = on_ground_ ? animation->src(anim_id_) : nullptr;
+        if (!src) src = &jump_.src;
+        draw_texture(r, jump_.texture, src, SDL_FRect{ x_, y_, w_, h_ });
         // コライダー可視化
-        if (blackboard && blackboard->getf("show_hitbox", 0.0f) > 0.5f) {
+        if (show_hitbox_) {
             if (collision_world && collider_id_ != 0) {
                 if (auto* c = collision_world->find(collider_id_)) {
-                    c->debug_render_filled(r);
+                    if (camera) c->debug_render_filled(r, camera->origin(), camera->scale());
+                    else c->debug_render_filled(r);
                 }
             }
         }
@@ -128,14 +168,15 @@ private:
         on_ground_ = false;
         vy_ = -jump_speed_;
     }
+    void update_anim_speed_() {
+        if (animation && anim_id_ != 0) animation->set_speed(anim_id_, on_ground_ ? 1.0f : 0.0f);
+    }
     // コライダー設定
     static constexpr std::uint32_t kLayerPlayer   = 1u << 0;
     static constexpr std::uint32_t kLayerObstacle = 1u << 1;
     static constexpr std::uint32_t kMaskPlayerHits = kLayerObstacle;
-    // テクスチャ
-    SDL_Texture* sprite_tex_ = nullptr;
-    SDL_FRect run_src_[2]{};
-    SDL_FRect jump_src_{};
+    // スプライト（ジャンプ. 走りはアニメーションサービスで回す）
+    NeneSprite jump_{};
     // 位置とサイズ
     float x_ = 0.0f;
     float y_ = 0.0f;
@@ -145,14 +186,20 @@ private:
     float vy_ = 0.0f;
     bool  on_ground_ = true;
     bool  dead_ = false;
-    // アニメーション設定
-    float anim_accum_ = 0.0f;
-    int   anim_idx_ = 0;
+    // アニメーション
+    NeneAnimClipId run_clip_ = kNeneNoClip;
+    NeneAnimId anim_id_ = 0;
+    // コライダー可視化
+    NeneBBSubscription show_hitbox_sub_;
+    bool show_hitbox_ = false;
+    // 土ぼこり（子ノード）
+    NeneParticleEmitter* dust_ = nullptr;
     // 運動設定
     float jump_speed_    = 900.0f;
     float run_frame_sec_ = 0.10f;
     // CollisionWorld登録ID
     NeneCollisionWorld::ColliderId collider_id_ = 0;
+    NeneActionId jump_action_ = 0;
 };
 
 // 地面
@@ -164,18 +211,18 @@ protected:
         if (!asset_loader || !path_service || !blackboard) {
             nnthrow("services not ready (asset_loader/path_service/blackboard)");
         }
-        sprite_tex_ = asset_loader->get_texture(path_service->resolve("assets/sprites/sprite.png"));
+        const NeneSprite ground = asset_loader->sprite("ground");
+        sprite_tex_ = ground.texture;
         if (!sprite_tex_) nnthrow("failed to load ground sprite texture");
-        float tw = 0.0f, th = 0.0f;
-        if (!SDL_GetTextureSize(sprite_tex_, &tw, &th)) {
-            nnthrow("SDL_GetTextureSize failed");
-        }
-        constexpr float kSrcH = 28.0f;
-        src_ = SDL_FRect{ 0.0f, th - kSrcH, tw, kSrcH };
+        src_ = ground.src;
         scroll_ = 0.0f;
         // 背景扱いで奥へ
         set_render_z(-100);
     }
+    bool reset_node() override {
+        scroll_ = 0.0f;
+        return true;
+    }
     void handle_time_lapse(const float& dt) override {
         if (!blackboard) return;
         const float speed = blackboard->scroll_speed;
@@ -190,11 +237,11 @@ protected:
         if (!r || !blackboard || !sprite_tex_) return;
         const float ww = static_cast<float>(blackboard->window_w);
         const float y  = blackboard->ground_y - 10;
-        const float src_x = scroll_;
+        const float src_x = src_.x + scroll_;
         const float src_y = src_.y;
         const float src_h = src_.h;
         const float src_w = src_.w;
-        const float w1 = (src_x + ww <= src_w) ? ww : (src_w - src_x);
+        const float w1 = (scroll_ + ww <= src_w) ? ww : (src_w - scroll_);
         // 1枚目
         SDL_FRect s1{ src_x, src_y, w1, src_h };
         SDL_FRect d1{ 0.0f,  y,    w1, src_h };
@@ -202,7 +249,7 @@ protected:
         // 2枚目（wrap する場合のみ）
         const float w2 = ww - w1;
         if (w2 > 0.0f) {
-            SDL_FRect s2{ 0.0f, src_y, w2, src_h };
+            SDL_FRect s2{ src_.x, src_y, w2, src_h };
             SDL_FRect d2{ w1,   y,     w2, src_h };
             SDL_RenderTexture(r, sprite_tex_, &s2, &d2);
         }
@@ -217,7 +264,7 @@ private:
 class Cactus final : public NeneNode {
 public:
     struct Variant {
-        SDL_FRect src;
+        NeneSprite sprite;
         float w;
         float h;
     };
@@ -235,12 +282,12 @@ protected:
     void init_node() override {
         if (!asset_loader || !path_service || !blackboard) nnthrow("services not ready (asset_loader/path_service/blackboard)");
         if (!collision_world) nnthrow("services not ready (collision_world)");
-        sprite_tex_ = asset_loader->get_texture(path_service->resolve("assets/sprites/sprite.png"));
-        if (!sprite_tex_) nnthrow("failed to load sprite texture");
         // 種類ごとのサイズ・画像
+        sprite_tex_ = variant_.sprite.texture;
+        if (!sprite_tex_) nnthrow("failed to load sprite texture");
         w_ = variant_.w;
         h_ = variant_.h;
-        src_ = variant_.src;
+        src_ = variant_.sprite.src;
         // 画面右外から出現
         x_ = blackboard->window_w + spawn_margin_;
         y_ = blackboard->ground_y - h_;
@@ -264,26 +311,31 @@ protected:
         // コライダー登録
         collider_id_ = collision_world->add_collider(std::move(poly));
         speed_ = blackboard->scroll_speed;
+        show_hitbox_sub_ = blackboard->subscribe<bool>(blackboard->key<bool>("show_hitbox"),
+            [this](const bool& v) { show_hitbox_ = v; });
     }
     void handle_time_lapse(const float& dt) override {
         if (!blackboard) return;
         x_ -= speed_ * dt;
-        if (collision_world && collider_id_ != 0) {
-            collision_world->set_position(collider_id_, SDL_FPoint{ x_, y_ });
-        }
+        if (collider_id_ != 0) set_collider_position(collider_id_, SDL_FPoint{ x_, y_ });
         if (x_ + w_ < -despawn_margin_) {
             send_mail(NeneMail("cactus_factory", this->name, "despawn", this->name));
         }
     }
+    // 描画範囲（画面外に出たら描かない）
+    bool render_bounds(SDL_FRect& out) const override {
+        out = SDL_FRect{ x_, y_, w_, h_ };
+        return true;
+    }
     void render(SDL_Renderer* r) override {
         if (!r || !sprite_tex_) return;
-        SDL_FRect dst{ x_, y_, w_, h_ };
-        SDL_RenderTexture(r, sprite_tex_, &src_, &dst);
+        draw_texture(r, sprite_tex_, &src_, SDL_FRect{ x_, y_, w_, h_ });
         // コライダー可視化
-        if (blackboard && blackboard->getf("show_hitbox", 0.0f) > 0.5f) {
+        if (show_hitbox_) {
             if (collision_world && collider_id_ != 0) {
                 if (auto* c = collision_world->find(collider_id_)) {
-                    c->debug_render_filled(r);
+                    if (camera) c->debug_render_filled(r, camera->origin(), camera->scale());
+                    else c->debug_render_filled(r);
                 }
             }
         }
@@ -293,6 +345,8 @@ private:
     static constexpr std::uint32_t kLayerObstacle = 1u << 1;
     static constexpr std::uint32_t kMaskObstacleHits = kLayerPlayer;
     Variant variant_;
+    NeneBBSubscription show_hitbox_sub_;
+    bool show_hitbox_ = false;
     SDL_Texture* sprite_tex_ = nullptr;
     SDL_FRect src_{};
     float x_ = 0.0f, y_ = 0.0f, w_ = 0.0f, h_ = 0.0f;
@@ -309,42 +363,34 @@ public:
         : NeneFactory(std::move(name)) {}
 protected:
     void init_node() override {
-        const float small_base_x = 446.0f;
-        const float small_base_y = 0.0f;
-        const float small_w = 34.0f;
-        const float small_h = 70.0f;
-        cactus_variants_ = {
-            // 小
-            { SDL_FRect{ small_base_x+small_w*0, small_base_y, small_w, small_h }, small_w, small_h },
-            { SDL_FRect{ small_base_x+small_w*1, small_base_y, small_w, small_h }, small_w, small_h },
-            { SDL_FRect{ small_base_x+small_w*2, small_base_y, small_w, small_h }, small_w, small_h },
-            { SDL_FRect{ small_base_x+small_w*3, small_base_y, small_w, small_h }, small_w, small_h },
-            { SDL_FRect{ small_base_x+small_w*4, small_base_y, small_w, small_h }, small_w, small_h },
-            { SDL_FRect{ small_base_x+small_w*5, small_base_y, small_w, small_h }, small_w, small_h },
-        };
+        if (!asset_loader || !random) nnthrow("services not ready (asset_loader/random)");
+        // 乱数はルートの種から導いた自分用のストリーム（記録と再生で同じ並びになる）
+        rng_ = random->stream(this->name);
+        // 小さいサボテン（Game で登録済みのスプライト）
+        cactus_variants_.clear();
+        for (int i = 0; i < 6; ++i) {
+            const NeneSprite spr = asset_loader->sprite("cactus_small_" + std::to_string(i));
+            cactus_variants_.push_back(Cactus::Variant{ spr, spr.src.w, spr.src.h });
+        }
         // NeneFactory に型登録：spawnメールで cactus を生成する
         register_type("cactus",
             [this](std::string instance_name, std::string_view /*arg*/) -> std::unique_ptr<NeneNode> {
                 if (cactus_variants_.empty()) nnthrow("cactus_variants_ is empty");
 
-                std::uniform_int_distribution<int> dist(0, (int)cactus_variants_.size() - 1);
-                const auto v = cactus_variants_[dist(rng_)];
+                const auto v = cactus_variants_[rng_.range(0, (int)cactus_variants_.size() - 1)];
                 return std::make_unique<Cactus>(std::move(instance_name), v); // Cactus(name, Variant) :contentReference[oaicite:4]{index=4}
             }
         );
-        spawn_accum_ = 0.0f;
         obstacle_seq_ = 0;
         // 最初の出現までの時間（0.8〜1.6秒）
-        next_spawn_in_ = frand_(0.8f, 1.6f);
+        schedule_spawn_(frand_(0.8f, 1.6f));
     }
-    void handle_time_lapse(const float& dt) override {
-        spawn_accum_ += dt;
-        if (spawn_accum_ >= next_spawn_in_) {
-            spawn_accum_ = 0.0f;
-            spawn_obstacle_();
-            // 次の間隔をランダムに（0.7〜1.7秒）
-            next_spawn_in_ = frand_(0.7f, 1.7f);
-        }
+    // やり直し（出ているサボテンを片付けて最初の間隔から）
+    bool reset_node() override {
+        clear_children();
+        cancel_timer(spawn_timer_);
+        schedule_spawn_(frand_(0.8f, 1.6f));
+        return true;
     }
     void handle_nene_mail(const NeneMail& mail) override {
         // 障害物を消去
@@ -353,20 +399,24 @@ protected:
 private:
     std::vector<Cactus::Variant> cactus_variants_;
     void spawn_obstacle_() {
-        std::uniform_int_distribution<int> dist(0, static_cast<int>(cactus_variants_.size()) - 1);
-        const auto v = cactus_variants_[dist(rng_)];
+        const auto v = cactus_variants_[rng_.range(0, static_cast<int>(cactus_variants_.size()) - 1)];
         const std::string name = "cactus_" + std::to_string(obstacle_seq_++);
         add_child(std::make_unique<Cactus>(name, v));
     }
-    static float frand_(float a, float b) {
-        const float t = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
-        return a + (b - a) * t;
+    void schedule_spawn_(float sec) {
+        spawn_timer_ = set_timeout(sec, [this] {
+            spawn_obstacle_();
+            // 次の間隔をランダムに（0.7〜1.7秒）
+            schedule_spawn_(frand_(0.7f, 1.7f));
+        });
+    }
+    float frand_(float a, float b) {
+        return rng_.uniform(a, b);
     }
-    std::mt19937 rng_{ std::random_device{}() };
-    float spawn_accum_ = 0.0f;
+    NeneRng rng_;
+    NeneTimerId spawn_timer_ = 0;
     float spawn_interval_ = 1.35f;
     int obstacle_seq_ = 0;
-    float next_spawn_in_ = 1.0f;
 };
 
 // 審判（CollisionWorldを監視し続ける）
@@ -377,6 +427,10 @@ protected:
     void init_node() override {
         if (!collision_world) nnthrow("services not ready (collision_world)");
     }
+    bool reset_node() override {
+        prev_.clear();
+        return true;
+    }
     void handle_time_lapse(const float& dt) override {
         (void)dt;
         if (!collision_world) nnthrow("collision world lost");
@@ -437,25 +491,34 @@ protected:
         add_child(std::make_unique<Dino>("dino"));
         add_child(std::make_unique<Referee>("referee"));
         add_child(std::make_unique<CactusFactory>("cactus_factory"));
-    }
-    void handle_time_lapse(const float& dt) override {
         if (blackboard) {
-            float& score = blackboard->ensuref("score", 0.0f);
-            score += dt * 100.0f; // 毎秒100点
+            score_ = blackboard->key<float>("score");
+            game_over_ = blackboard->key<bool>("game_over");
         }
     }
+    // やり直し（止めたパルスを戻して子もリセット）
+    bool reset_node() override {
+        this->valve_time_lapse = true;
+        this->valve_input = true;
+        return reset_children();
+    }
+    void handle_time_lapse(const float& dt) override {
+        if (blackboard) blackboard->add(score_, dt * 100.0f); // 毎秒100点
+    }
     void handle_nene_mail(const NeneMail& mail) override {
         // Referee のブロードキャストを受けた時
         if (mail.subject == "collision_detected") {
-            // World 以下の time_lapse, sdl_event パルスを遮断
+            // World 以下の time_lapse, input パルスを遮断
             this->valve_time_lapse = false;
-            this->valve_sdl_event = false;
+            this->valve_input = false;
             // ゲームオーバーに移行
-            if (blackboard) blackboard->setf("game_over", 1.0f);
+            if (blackboard) blackboard->set(game_over_, true);
             return;
         }
     }
 private:
+    NeneBBKey<float> score_;
+    NeneBBKey<bool> game_over_;
 };
 
 
@@ -466,107 +529,98 @@ public:
 protected:
     void init_node() override {
         if (!font_loader || !path_service || !blackboard) nnthrow("services not ready (font_loader/path_service/blackboard)");
+        if (!input) nnthrow("services not ready (input)");
+        start_action_ = input->action("start", "Space");
         font_path_ = path_service->resolve("assets/fonts/NotoSansJP-Regular.ttf");
         // 固定テキストは一度だけ作ればOK
-        game_over_tex_ = font_loader->get_text_texture(font_path_, 64, "Game Over", SDL_Color{255,255,255,255});
-        restart_tex_ = font_loader->get_text_texture(font_path_, 24, "Press Space to Restart", SDL_Color{255,255,255,255});
-        // スコア初期テクスチャ
-        update_score_texture_(0);
-        // 初期状態
-        last_score_int_ = 0;
+        game_over_text_ = font_loader->make_text(font_loader->font_id(font_path_, 64), SDL_Color{255,255,255,255}, "Game Over");
+        restart_text_ = font_loader->make_text(font_loader->font_id(font_path_, 24), SDL_Color{255,255,255,255}, "Press Space to Restart");
+        // スコアは毎フレーム変わるのでグリフアトラスで描く
+        score_font_ = font_loader->glyph_atlas(font_loader->font_id(font_path_, 28));
+        last_score_int_ = -1;
         // 手前に表示される
         set_render_z(1000);
         // 点滅アニメーション設定
-        blink_accum_ = 0.0f;
         press_visible_ = true;
-    }
-    void handle_time_lapse(const float& dt) override {
-        if (!blackboard) return;
-        // スコア表示更新（score が変化したときだけテクスチャ更新）
-        const int score_i = static_cast<int>(blackboard->getf("score", 0.0f));
-        if (score_i != last_score_int_) {
-            last_score_int_ = score_i;
-            update_score_texture_(score_i);
-        }
-        // Game Over 中だけ「Press...」を点滅
-        const bool game_over = (blackboard->getf("game_over", 0.0f) > 0.5f);
-        if (game_over) {
-            blink_accum_ += dt;
-            if (blink_accum_ >= 0.5f) {
-                blink_accum_ = 0.0f;
-                press_visible_ = !press_visible_;
-            }
-        } else {
-            // Game Overじゃないときは常に表示状態に戻す
-            blink_accum_ = 0.0f;
-            press_visible_ = true;
-        }
+        // score / game_over は変わったフレームだけ受け取る（登録時に現在値で1回呼ばれる）
+        score_sub_ = blackboard->subscribe<float>(blackboard->key<float>("score"),
+            [this](const float& v) {
+                // 表示が変わるときだけ文字列を作り直す
+                const int score_i = static_cast<int>(v);
+                if (score_i == last_score_int_) return;
+                last_score_int_ = score_i;
+                update_score_text_(score_i);
+            });
+        game_over_sub_ = blackboard->subscribe<bool>(blackboard->key<bool>("game_over"),
+            [this](const bool& v) {
+                game_over_ = v;
+                // Game Over 中だけ「Press...」を点滅. Game Overじゃないときは常に表示状態に戻す
+                cancel_timer(blink_timer_);
+                blink_timer_ = 0;
+                press_visible_ = true;
+                if (v) blink_timer_ = set_interval(0.5f, [this] { press_visible_ = !press_visible_; });
+            });
+    }
+    bool reset_node() override {
+        cancel_timer(blink_timer_);
+        blink_timer_ = 0;
+        press_visible_ = true;
+        return true;
     }
     void render(SDL_Renderer* r) override {
-        if (!r || !blackboard) return;
-        if (!score_tex_) return;
+        if (!r) return;
+        if (!score_font_) return;
         int w = 0, h = 0;
         if (!SDL_GetRenderOutputSize(r, &w, &h)) return;
         // スコア
-        float sw = 0.0f, sh = 0.0f;
-        SDL_GetTextureSize(score_tex_, &sw, &sh);
+        const std::string_view score_text(score_buf_, score_len_);
+        const SDL_FPoint size = score_font_->measure(score_text);
         const float pad = 16.0f;
-        SDL_FRect score_dst{
-            static_cast<float>(w) - pad - sw,
-            pad,
-            sw, sh
-        };
-        SDL_RenderTexture(r, score_tex_, nullptr, &score_dst);
+        score_font_->draw(score_text, static_cast<float>(w) - pad - size.x, pad, SDL_Color{255,255,255,255});
         // Game Over文字
-        const bool game_over = (blackboard->getf("game_over", 0.0f) > 0.5f);
-        if (!game_over) return;
-        if (game_over_tex_) {
-            float gw = 0.0f, gh = 0.0f;
-            SDL_GetTextureSize(game_over_tex_, &gw, &gh);
-            SDL_FRect go_dst{
-                (static_cast<float>(w) - gw) * 0.5f,
-                (static_cast<float>(h) - gh) * 0.5f - 40.0f,
-                gw, gh
-            };
-            SDL_RenderTexture(r, game_over_tex_, nullptr, &go_dst);
+        if (!game_over_) return;
+        if (game_over_text_) {
+            game_over_text_.draw(
+                (static_cast<float>(w) - game_over_text_.width()) * 0.5f,
+                (static_cast<float>(h) - game_over_text_.height()) * 0.5f - 40.0f);
         }
-        if (restart_tex_ && press_visible_) {
-            float rw = 0.0f, rh = 0.0f;
-            SDL_GetTextureSize(restart_tex_, &rw, &rh);
-            SDL_FRect rs_dst{
-                (static_cast<float>(w) - rw) * 0.5f,
-                (static_cast<float>(h) - rh) * 0.5f + 40.0f,
-                rw, rh
-            };
-            SDL_RenderTexture(r, restart_tex_, nullptr, &rs_dst);
+        if (restart_text_ && press_visible_) {
+            restart_text_.draw(
+                (static_cast<float>(w) - restart_text_.width()) * 0.5f,
+                (static_cast<float>(h) - restart_text_.height()) * 0.5f + 40.0f);
         }
     }
-    void handle_sdl_event(const SDL_Event& ev) override {
-        if (!blackboard) return;
-        const bool game_over = (blackboard->getf("game_over", 0.0f) > 0.5f);
-        if (!game_over) return;
-        if (ev.type == SDL_EVENT_KEY_DOWN) {
-            if (ev.key.key == SDLK_SPACE) {
-                // スイッチ: PlayScene → PlayScene (これでリセットできる)
-                send_mail(NeneMail("scene_switch", this->name, "switch_to", "play_scene"));
-            }
+    void handle_input(const NeneInput& in) override {
+        if (!game_over_) return;
+        if (in.pressed(start_action_)) {
+            // スイッチ: PlayScene → PlayScene (これでリセットできる)
+            send_mail(NeneMail("scene_switch", this->name, "switch_to", "play_scene"));
         }
     }
 private:
-    void update_score_texture_(int score_i) {
-        // スコアの表示(5桁)
-        std::string s = std::to_string(score_i);
-        if (s.size() < 5) s = std::string(5 - s.size(), '0') + s;
-        score_tex_ = font_loader->get_text_texture(
-            font_path_, 28, s, SDL_Color{255,255,255,255});
+    void update_score_text_(int score_i) {
+        // スコアの表示(5桁ゼロ埋め). 固定バッファに書くのでアロケーションしない
+        char digits[16];
+        const auto res = std::to_chars(digits, digits + sizeof(digits), score_i);
+        const int n = static_cast<int>(res.ptr - digits);
+        const int zeros = (n < 5) ? 5 - n : 0;
+        score_len_ = 0;
+        for (int i = 0; i < zeros; ++i) score_buf_[score_len_++] = '0';
+        for (int i = 0; i < n; ++i) score_buf_[score_len_++] = digits[i];
     }
     std::string font_path_;
-    SDL_Texture* score_tex_ = nullptr;
-    SDL_Texture* game_over_tex_ = nullptr;
-    SDL_Texture* restart_tex_ = nullptr;
+    NeneBBSubscription score_sub_;
+    NeneBBSubscription game_over_sub_;
+    bool game_over_ = false;
+    NeneGlyphAtlas* score_font_ = nullptr;
+    char score_buf_[24]{};
+    std::size_t score_len_ = 0;
+    NeneTextHandle game_over_text_;
+    NeneTextHandle restart_text_;
     int last_score_int_ = 0;
-    float blink_accum_ = 0.0f;
+    NeneTimerId blink_timer_ = 0;
     bool  press_visible_ = true;
+    NeneActionId start_action_ = 0;
 };
 
 
@@ -577,16 +631,24 @@ public:
 protected:
     void init_node(){
         if (blackboard) {
-            blackboard->setf("score", 0.0f);
-            blackboard->setf("game_over", 0.0f);
+            blackboard->set(blackboard->key<float>("score"), 0.0f);
+            blackboard->set(blackboard->key<bool>("game_over"), false);
             // コライダー可視化
-            blackboard->setf("show_hitbox", 1.0f);
+            blackboard->set(blackboard->key<bool>("show_hitbox"), true);
         }
         if (collision_world) collision_world->clear(); // リセットのためにコライダーをクリア
         else nnerr("no collision world");
         add_child(std::make_unique<World>("world"));
         add_child(std::make_unique<Overlay>("overlay"));
     }
+    // リトライは作り直さずにその場で戻す（コライダーもテクスチャもそのまま）
+    bool reset_node() override {
+        if (blackboard) {
+            blackboard->set(blackboard->key<float>("score"), 0.0f);
+            blackboard->set(blackboard->key<bool>("game_over"), false);
+        }
+        return reset_children();
+    }
 };
 
 // タイトルシーン
@@ -597,34 +659,33 @@ protected:
     void init_node() override {
         // 共有サービスは add_child 時に親から引き継がれている想定
         if (!asset_loader || !font_loader || !path_service) nnthrow("services not ready (asset_loader/font_loader/path_service)");
+        if (!input) nnthrow("services not ready (input)");
+        start_action_ = input->action("start", "Space");
         // スプライト
-        sprite_tex_ = asset_loader->get_texture(path_service->resolve("assets/sprites/sprite.png"));
+        dino_ = asset_loader->sprite("dino_run_0");
         // フォント
         font_path_ = path_service->resolve("assets/fonts/NotoSansJP-Regular.ttf");
         // タイトル文字
-        title_tex_ = font_loader->get_text_texture(font_path_, 56, "ChromeDino", SDL_Color{255, 255, 255, 255});
+        title_text_ = font_loader->make_text(font_loader->font_id(font_path_, 56), SDL_Color{255, 255, 255, 255}, "ChromeDino");
         // 「Press...」文字
-        press_tex_ = font_loader->get_text_texture(font_path_, 24, "Press Space to Start", SDL_Color{255, 255, 255, 255});
+        press_text_ = font_loader->make_text(font_loader->font_id(font_path_, 24), SDL_Color{255, 255, 255, 255}, "Press Space to Start");
+        // 0.5秒ごとにON/OFF
+        set_interval(0.5f, [this] { press_visible_ = !press_visible_; });
     }
     void render(SDL_Renderer* r) override {
         if (!r) return;
-        if (!sprite_tex_ || !title_tex_ || !press_tex_) return;
+        if (!dino_.texture || !title_text_ || !press_text_) return;
         // 画面サイズ
         int w = 0, h = 0;
         if (!SDL_GetRenderOutputSize(r, &w, &h)) return;
         // 恐竜 (テクスチャアトラス内)
-        const SDL_FRect dino_src { 1514.2f, 0.0f, 88.0f, 96.0f };
-        const float dino_w = 88.0f;
-        const float dino_h = 96.0f;
-        // タイトル文字のテクスチャサイズ
-        float text_w = 0.0f, text_h = 0.0f;
-        if (!SDL_GetTextureSize(title_tex_, &text_w, &text_h)) {
-            text_w = 0.0f;
-            text_h = 0.0f;
-        }
+        const float dino_w = dino_.src.w;
+        const float dino_h = dino_.src.h;
+        // タイトル文字サイズ
+        const float text_w = title_text_.width();
+        const float text_h = title_text_.height();
         // 「Press...」文字サイズ
-        float press_w = 0.0f, press_h = 0.0f;
-        SDL_GetTextureSize(press_tex_, &press_w, &press_h);
+        const float press_w = press_text_.width();
         // 横並びレイアウト：中央寄せ
         const float gap = 28.0f;
         const float total_w = dino_w + gap + text_w;
@@ -632,42 +693,30 @@ protected:
         const float x0 = (static_cast<float>(w) - total_w) * 0.5f;
         const float y0 = (static_cast<float>(h) * 0.5f) - (group_h * 0.5f); // 画面のちょうど半分の高さ
         SDL_FRect dino_dst { x0, y0 + (group_h - dino_h) * 0.5f, dino_w, dino_h };
-        SDL_FRect text_dst { x0 + dino_w + gap, y0 + (group_h - text_h) * 0.5f, text_w, text_h };
-        SDL_RenderTexture(r, sprite_tex_, &dino_src, &dino_dst);
-        SDL_RenderTexture(r, title_tex_, nullptr, &text_dst);
+        SDL_RenderTexture(r, dino_.texture, &dino_.src, &dino_dst);
+        title_text_.draw(x0 + dino_w + gap, y0 + (group_h - text_h) * 0.5f);
         // 「Press...」を少し下に、中央寄せ、点滅
         if (press_visible_) {
             const float press_x = (static_cast<float>(w) - press_w) * 0.5f;
             const float press_y = y0 + group_h + 40.0f;
-            SDL_FRect press_dst{ press_x, press_y, press_w, press_h };
-            SDL_RenderTexture(r, press_tex_, nullptr, &press_dst);
-        }
-    }
-    void handle_sdl_event(const SDL_Event& ev) override
-    {
-        if (ev.type == SDL_EVENT_KEY_DOWN) {
-            if (ev.key.key == SDLK_SPACE) {
-                // scene_switch にメールでシーン切替要求
-                // (to, from, subject, body)
-                send_mail(NeneMail("scene_switch", this->name, "switch_to", "play_scene"));
-            }
+            press_text_.draw(press_x, press_y);
         }
     }
-    void handle_time_lapse(const float& dt) override
+    void handle_input(const NeneInput& in) override
     {
-        blink_accum_ += dt;
-        if (blink_accum_ >= 0.5f) { // 0.5秒ごとにON/OFF
-            blink_accum_ = 0.0f;
-            press_visible_ = !press_visible_;
+        if (in.pressed(start_action_)) {
+            // scene_switch にメールでシーン切替要求
+            // (to, from, subject, body)
+            send_mail(NeneMail("scene_switch", this->name, "switch_to", "play_scene"));
         }
     }
 private:
-    SDL_Texture* sprite_tex_ = nullptr;
-    SDL_Texture* title_tex_  = nullptr;
-    SDL_Texture* press_tex_  = nullptr;
+    NeneSprite dino_{};
+    NeneTextHandle title_text_;
+    NeneTextHandle press_text_;
     std::string font_path_;
-    float blink_accum_ = 0.0f;
     bool  press_visible_ = true;
+    NeneActionId start_action_ = 0;
 };
 
 // シーンスイッチ
@@ -682,7 +731,15 @@ protected:
         register_node("play_scene", [] {
             return std::make_unique<PlayScene>("play_scene");
         });
+        // シーンごとのアセット
+        if (path_service) {
+            const NeneAssetManifest sprites{ { path_service->resolve("assets/sprites/sprite.png") } };
+            register_manifest("title_scene", sprites);
+            register_manifest("play_scene", sprites);
+        }
         set_initial_node("title_scene");
+        // タイトル表示中にプレイシーンのアセットを温めて, 読み終わったら組み立てておく
+        prepare("play_scene");
     }
 };
 
@@ -702,10 +759,34 @@ public:
     {}
 protected:
     void init_node() override {
+        // 入力は全部 NeneInput で受けるので, SDL イベントは木に流さない
+        set_sdl_event_walk(false);
+        // スプライト登録（アトラス座標はここだけに書く）
+        register_sprites_();
+        // オーバーレイ（z>=1000）はカメラに追従しない
+        if (camera) camera->add_layer(NeneParallaxLayer{ 1000, std::numeric_limits<int>::max(), 0.0f, false });
         // シーンスイッチを生成.
         add_child(std::make_unique<SceneSwitch>("scene_switch"));
     }
 private:
+    void register_sprites_() {
+        if (!asset_loader || !path_service) nnthrow("services not ready (asset_loader/path_service)");
+        const std::string sheet = path_service->resolve("assets/sprites/sprite.png");
+        // 恐竜（走り2コマ）
+        asset_loader->register_sprite("dino_run_0", sheet, SDL_FRect{ 1514.2f, 0.0f, 88.0f, 96.0f });
+        asset_loader->register_sprite("dino_run_1", sheet, SDL_FRect{ 1602.2f, 0.0f, 88.0f, 96.0f });
+        // 小さいサボテン（6種類が横に並んでいる）
+        constexpr float kSmallX = 446.0f, kSmallW = 34.0f, kSmallH = 70.0f;
+        for (int i = 0; i < 6; ++i) {
+            asset_loader->register_sprite("cactus_small_" + std::to_string(i), sheet,
+                SDL_FRect{ kSmallX + kSmallW * static_cast<float>(i), 0.0f, kSmallW, kSmallH });
+        }
+        // 地面（シートの一番下の帯）
+        float tw = 0.0f, th = 0.0f;
+        if (!SDL_GetTextureSize(asset_loader->get_texture(sheet), &tw, &th)) nnthrow("SDL_GetTextureSize failed");
+        constexpr float kGroundH = 28.0f;
+        asset_loader->register_sprite("ground", sheet, SDL_FRect{ 0.0f, th - kGroundH, tw, kGroundH });
+    }
     static const std::string& icon_path() {
         static std::string p = PathService::resolve_base("assets/icons/T-Rex.svg");
         return p;
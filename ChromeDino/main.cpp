@@ -1,14 +1,21 @@
 // main.cpp
 #include <memory>
+#include <string>
 #include <SDL3/SDL_main.h>
 #include <NeneEngine/NeneNode.hpp>
 
 // ゲームを生成
 std::unique_ptr<NeneRoot> create_game();
 
-int main(int, char**) {
+int main(int argc, char** argv) {
     try {
         auto game = create_game();
+        // --record <file>: 入力を記録 / --replay <file>: 記録を全速で再生（性能計測用）
+        for (int i = 1; i + 1 < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--record") game->record_to(argv[++i]);
+            else if (arg == "--replay") game->replay_from(argv[++i]);
+        }
         return game->run();
     } catch (const std::exception& e) {
         SDL_Log("FATAL: %s", e.what());
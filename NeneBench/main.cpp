@@ -0,0 +1,93 @@
+// main.cpp
+// 並列パルスの計測（窓を開かずに time_lapse だけ回す）
+// NeneBench [子の数] [フレーム数] [1つの子の粒子数] [ワーカー数（0 ならコア数-1）]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include <NeneEngine/NeneNode.hpp>
+
+namespace {
+constexpr float kDt = 1.0f / 60.0f;
+
+// 重い子（自分の粒子を積分するだけで, 他の子には触らない）
+class Swarm : public NeneNode {
+public:
+    Swarm(std::string name, std::uint64_t seed, int particles)
+        : NeneNode(std::move(name)), x_(particles), v_(particles) {
+        NeneRng rng(seed);
+        rng.fill_uniform(x_, -1.0f, 1.0f);
+        rng.fill_uniform(v_, -1.0f, 1.0f);
+    }
+    double checksum() const {
+        double sum = 0.0;
+        for (float x : x_) sum += x;
+        return sum;
+    }
+private:
+    void handle_time_lapse(const float& dt) override {
+        for (std::size_t i = 0; i < x_.size(); ++i) {
+            v_[i] += (std::sin(x_[i] * 3.0f) - x_[i]) * dt;
+            x_[i] += v_[i] * dt;
+        }
+    }
+    std::vector<float> x_;
+    std::vector<float> v_;
+};
+
+// 計測用の木（独立な Swarm を並べる）
+class Bench : public NeneNode {
+public:
+    Bench(int children, int particles, std::shared_ptr<NeneWorkerPool> pool) : NeneNode("bench") {
+        worker_pool = std::move(pool);
+        mail_server = std::make_shared<NeneMailServer>();
+        for (int i = 0; i < children; ++i) {
+            add_child(std::make_unique<Swarm>("swarm" + std::to_string(i), static_cast<std::uint64_t>(i), particles));
+        }
+    }
+    // 1フレームの平均（ms）
+    double run(int frames, bool parallel) {
+        set_children_independent(parallel);
+        pulse_time_lapse(kDt); // ワーカーを起こす分は数えない
+        const auto start = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; ++f) pulse_time_lapse(kDt);
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / frames;
+    }
+    double checksum() const {
+        double sum = 0.0;
+        for (const auto& kv : children) sum += static_cast<const Swarm&>(*kv.second).checksum();
+        return sum;
+    }
+};
+
+int arg_or(int argc, char** argv, int i, int fallback) {
+    return (i < argc) ? std::max(1, std::atoi(argv[i])) : fallback;
+}
+}
+
+int main(int argc, char** argv) {
+    const int children  = arg_or(argc, argv, 1, 64);
+    const int frames    = arg_or(argc, argv, 2, 300);
+    const int particles = arg_or(argc, argv, 3, 20000);
+    const unsigned workers = (argc > 4) ? static_cast<unsigned>(std::atoi(argv[4])) : 0u;
+    auto pool = std::make_shared<NeneWorkerPool>(workers);
+    std::printf("children=%d frames=%d particles=%d threads=%u\n", children, frames, particles, pool->thread_count());
+
+    // 同じ初期値から回して, 並列でも結果が変わらないことも確かめる
+    Bench serial(children, particles, pool);
+    const double serial_ms = serial.run(frames, false);
+    Bench parallel(children, particles, pool);
+    const double parallel_ms = parallel.run(frames, true);
+    std::printf("serial   : %8.3f ms/frame\n", serial_ms);
+    std::printf("parallel : %8.3f ms/frame (x%.2f)\n", parallel_ms, serial_ms / parallel_ms);
+    if (serial.checksum() != parallel.checksum()) {
+        std::printf("checksum mismatch: %.17g != %.17g\n", serial.checksum(), parallel.checksum());
+        return 1;
+    }
+    return 0;
+}
@@ -1,9 +1,14 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <deque>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string_view>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <stdexcept>
 #include <vector>
@@ -16,7 +21,46 @@
 #include <variant>
 #include <SDL3_image/SDL_image.h>
 
-// ステートマシン
+// 固定長リングバッファ（いっぱいのときは push が false を返す）
+template <class T>
+class NeneRingBuffer {
+public:
+    // 既定では空（T の既定構築は容量を決めたときにだけ要る）
+    NeneRingBuffer() = default;
+    explicit NeneRingBuffer(std::size_t capacity) { reset_capacity(capacity); }
+    // 容量変更（中身は捨てる）
+    void reset_capacity(std::size_t capacity) {
+        buf_.assign(capacity, T{});
+        head_ = 0;
+        size_ = 0;
+    }
+    bool push(T v) {
+        if (size_ == buf_.size()) return false;
+        buf_[(head_ + size_) % buf_.size()] = std::move(v);
+        ++size_;
+        return true;
+    }
+    T& front() { return buf_[head_]; }
+    void pop() {
+        if (size_ == 0) return;
+        head_ = (head_ + 1) % buf_.size();
+        --size_;
+    }
+    void clear() { head_ = 0; size_ = 0; }
+    bool empty() const { return size_ == 0; }
+    bool full() const { return size_ == buf_.size(); }
+    std::size_t size() const { return size_; }
+    std::size_t capacity() const { return buf_.size(); }
+private:
+    std::vector<T> buf_;
+    std::size_t head_ = 0;
+    std::size_t size_ = 0;
+};
+
+// ステートマシン（階層つき）
+// add_state で親を指定すると子状態になる. 子が持たないハンドラは親のものが使われる
+// update/dispatch は末端の状態から親へ順に呼び, 遷移を返したところで止まる
+// 親状態への遷移は既定の子（最初に登録した子. set_default_child で変更可）まで入る
 template <class StateId, class Context, class Event = std::monostate>
 class NeneStateMachine {
 public:
@@ -38,61 +82,77 @@ public:
     }
     // 状態登録
     void add_state(StateId id, State st) {
-        states_[id] = std::move(st);
+        states_[id].state = std::move(st);
+    }
+    // 子状態として登録（親は先に登録しておく）
+    void add_state(StateId id, State st, StateId parent) {
+        Node& p = node_ref_(parent);
+        if (!p.default_child) p.default_child = id;
+        Node& n = states_[id];
+        n.state = std::move(st);
+        n.parent = parent;
+    }
+    void set_default_child(StateId parent, StateId child) {
+        ensure_state_(child);
+        node_ref_(parent).default_child = child;
     }
     bool has_state(StateId id) const {
         return states_.find(id) != states_.end();
     }
-    // 初期化（enter も呼ぶ）
+    // 初期化（根から順に enter も呼ぶ）
+    // enter/exit の中から呼ばれたときは transition_to と同じく積んでおく
     void set_initial(StateId id, Context& ctx) {
         ensure_state_(id);
-        current_ = id;
+        if (in_transition_) {
+            pending_.push_back(id);
+            return;
+        }
         started_ = true;
-        call_enter_(id, ctx);
+        current_.reset();
+        run_transitions_(id, ctx);
     }
     bool started() const { return started_; }
+    // 現在の末端の状態
     std::optional<StateId> current() const { return current_; }
-    // 強制遷移（exit->enter）
+    // id が現在の状態かその祖先なら true
+    bool in_state(StateId id) const {
+        for (auto s = current_; s.has_value(); s = node_ref_(*s).parent) {
+            if (*s == id) return true;
+        }
+        return false;
+    }
+    // 強制遷移（共通の祖先までを exit->目的の状態まで enter）
+    // enter/exit の中からの遷移要求は順に積んでおき, 今の遷移が終わってから処理する
     void transition_to(StateId next, Context& ctx) {
         ensure_state_(next);
         if (!started_) {
             set_initial(next, ctx);
             return;
         }
-        if (current_.has_value() && current_.value() == next) return;
-        // 遷移中にさらに遷移要求が来たときの安全策：キューに積む
-        pending_ = next;
-        if (in_transition_) return;
-        in_transition_ = true;
-        while (pending_.has_value()) {
-            const StateId target = pending_.value();
-            pending_.reset();
-            if (current_.has_value()) {
-                call_exit_(current_.value(), ctx);
-            }
-            current_ = target;
-            call_enter_(target, ctx);
-        }
-        in_transition_ = false;
+        run_transitions_(next, ctx);
     }
     // 更新
     void update(Context& ctx, float dt) {
         if (!started_ || !current_.has_value()) return;
-        const State& st = state_ref_(current_.value());
-        if (!st.on_update) return;
-
-        if (auto next = st.on_update(ctx, dt)) {
-            transition_to(*next, ctx);
+        for (auto s = current_; s.has_value(); s = node_ref_(*s).parent) {
+            const State& st = node_ref_(*s).state;
+            if (!st.on_update) continue;
+            if (auto next = st.on_update(ctx, dt)) {
+                transition_to(*next, ctx);
+                return;
+            }
         }
     }
     // イベント投入（Event を使う場合）
     void dispatch(Context& ctx, const Event& ev) {
         if (!started_ || !current_.has_value()) return;
-        const State& st = state_ref_(current_.value());
-        if (!st.on_event) return;
-
-        if (auto next = st.on_event(ctx, ev)) {
-            transition_to(*next, ctx);
+        for (auto s = current_; s.has_value(); s = node_ref_(*s).parent) {
+            const State& st = node_ref_(*s).state;
+            if (!st.on_event) continue;
+            if (auto next = st.on_event(ctx, ev)) {
+                transition_to(*next, ctx);
+                return;
+            }
         }
     }
     // 便利：イベント型を使わない場合でも呼べるように
@@ -100,41 +160,822 @@ public:
     void dispatch(Context& ctx) {
         dispatch(ctx, Event{});
     }
+    // イベントキュー. post で積んで process_events でまとめて処理する（毎フレーム1回呼ぶ想定）
+    // キューは最初の post か set_event_capacity で確保する（積んであったイベントは捨てる）
+    void set_event_capacity(std::size_t n) {
+        event_capacity_ = n;
+        events_.reset_capacity(n);
+    }
+    // キューがいっぱいなら false
+    bool post(Event ev) {
+        if (events_.capacity() == 0) events_.reset_capacity(event_capacity_);
+        return events_.push(std::move(ev));
+    }
+    std::size_t pending_events() const { return events_.size(); }
+    // 呼んだ時点で積まれていた分だけ処理する（処理中に post されたものは次の呼び出しで）
+    void process_events(Context& ctx) {
+        for (std::size_t n = events_.size(); n > 0 && !events_.empty(); --n) {
+            Event ev = std::move(events_.front());
+            events_.pop();
+            dispatch(ctx, ev);
+        }
+    }
 private:
+    struct Node {
+        State state;
+        std::optional<StateId> parent;
+        std::optional<StateId> default_child;
+    };
     void ensure_state_(StateId id) const {
         if (!has_state(id)) {
             throw std::runtime_error("NeneStateMachine: unknown state");
         }
     }
-    const State& state_ref_(StateId id) const {
+    const Node& node_ref_(StateId id) const {
         auto it = states_.find(id);
         if (it == states_.end()) {
             throw std::runtime_error("NeneStateMachine: state not found");
         }
         return it->second;
     }
-    State& state_ref_(StateId id) {
+    Node& node_ref_(StateId id) {
         auto it = states_.find(id);
         if (it == states_.end()) {
             throw std::runtime_error("NeneStateMachine: state not found");
         }
         return it->second;
     }
+    // 遷移要求を積み, 遷移中でなければ積まれた分を順に処理する
+    void run_transitions_(StateId first, Context& ctx) {
+        pending_.push_back(first);
+        if (in_transition_) return;
+        in_transition_ = true;
+        struct Guard {
+            NeneStateMachine* self;
+            ~Guard() { self->in_transition_ = false; self->pending_.clear(); }
+        } guard{this};
+        while (!pending_.empty()) {
+            const StateId target = pending_.front();
+            pending_.pop_front();
+            if (current_.has_value() && current_.value() == target) continue;
+            // 共通の祖先を探す
+            std::optional<StateId> lca;
+            for (auto s = node_ref_(target).parent; s.has_value(); s = node_ref_(*s).parent) {
+                if (in_state(*s)) { lca = s; break; }
+            }
+            // 目的の状態が現在の祖先なら, それ自体は出入りしない
+            if (in_state(target)) lca = target;
+            while (current_.has_value() && current_ != lca) {
+                const StateId s = current_.value();
+                Node& n = node_ref_(s);
+                if (n.state.on_exit) n.state.on_exit(ctx);
+                current_ = n.parent;
+            }
+            enter_from_(lca, target, ctx);
+        }
+    }
+    // from（含まない）の下から target まで enter し, さらに既定の子まで入る
+    void enter_from_(std::optional<StateId> from, StateId target, Context& ctx) {
+        std::vector<StateId> path;
+        for (std::optional<StateId> s = target; s.has_value() && s != from; s = node_ref_(*s).parent) {
+            path.push_back(*s);
+        }
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            current_ = *it;
+            Node& n = node_ref_(*it);
+            if (n.state.on_enter) n.state.on_enter(ctx);
+        }
+        current_ = target;
+        for (auto c = node_ref_(target).default_child; c.has_value(); c = node_ref_(*c).default_child) {
+            current_ = *c;
+            Node& n = node_ref_(*c);
+            if (n.state.on_enter) n.state.on_enter(ctx);
+        }
+    }
+private:
+    std::unordered_map<StateId, Node> states_;
+    std::optional<StateId> current_;
+    bool started_ = false;
+    // 遷移の再入対策
+    bool in_transition_ = false;
+    std::deque<StateId> pending_;
+    NeneRingBuffer<Event> events_;
+    std::size_t event_capacity_ = 64;
+};
+
+// 直交領域（同じ Context を共有する複数のステートマシンを並べて動かす）
+// イベントは全領域に配られる
+template <class StateId, class Context, class Event = std::monostate>
+class NeneStateRegions {
+public:
+    using Machine = NeneStateMachine<StateId, Context, Event>;
+    explicit NeneStateRegions(std::size_t event_capacity = 64) : event_capacity_(event_capacity) {}
+    // 領域追加（戻り値の参照は領域を追加しても無効にならない）
+    Machine& add_region() {
+        regions_.push_back(std::make_unique<Machine>());
+        return *regions_.back();
+    }
+    Machine& region(std::size_t i) { return *regions_.at(i); }
+    std::size_t region_count() const { return regions_.size(); }
+    bool in_state(StateId id) const {
+        for (const auto& r : regions_) {
+            if (r->in_state(id)) return true;
+        }
+        return false;
+    }
+    void update(Context& ctx, float dt) {
+        for (auto& r : regions_) r->update(ctx, dt);
+    }
+    void dispatch(Context& ctx, const Event& ev) {
+        for (auto& r : regions_) r->dispatch(ctx, ev);
+    }
+    void set_event_capacity(std::size_t n) {
+        event_capacity_ = n;
+        events_.reset_capacity(n);
+    }
+    bool post(Event ev) {
+        if (events_.capacity() == 0) events_.reset_capacity(event_capacity_);
+        return events_.push(std::move(ev));
+    }
+    std::size_t pending_events() const { return events_.size(); }
+    void process_events(Context& ctx) {
+        for (std::size_t n = events_.size(); n > 0 && !events_.empty(); --n) {
+            Event ev = std::move(events_.front());
+            events_.pop();
+            dispatch(ctx, ev);
+        }
+    }
+private:
+    std::vector<std::unique_ptr<Machine>> regions_;
+    NeneRingBuffer<Event> events_;
+    std::size_t event_capacity_ = 64;
+};
+
+// 軽量ステートマシン（enum class の StateId 用）
+// 状態は enum の値で引く配列に持つ（ハッシュを引かない）. enum の最後に Count を置くか StateCount を渡す
+// ハンドラは関数ポインタ（キャプチャしないラムダも渡せる）. Handlers を渡すと静的に呼ぶのでインライン化される
+//   struct Handlers {
+//       static void on_enter(StateId, Context&);
+//       static void on_exit(StateId, Context&);
+//       static std::optional<StateId> on_update(StateId, Context&, float);
+//       static std::optional<StateId> on_event(StateId, Context&, const Event&);
+//   };
+template <class StateId, class Context, class Event = std::monostate, class Handlers = void,
+          std::size_t StateCount = static_cast<std::size_t>(StateId::Count)>
+class NeneFastStateMachine {
+    static_assert(std::is_enum_v<StateId>, "NeneFastStateMachine: StateId must be an enum");
+    static constexpr bool kStatic = !std::is_void_v<Handlers>;
+public:
+    using Transition = std::optional<StateId>;
+    struct State {
+        void (*on_enter)(Context&) = nullptr;
+        void (*on_exit)(Context&) = nullptr;
+        Transition (*on_update)(Context&, float) = nullptr;
+        Transition (*on_event)(Context&, const Event&) = nullptr;
+    };
+    static constexpr std::size_t state_count = StateCount;
+    // 状態登録（Handlers を使うときは不要）
+    void add_state(StateId id, State st) {
+        static_assert(!kStatic, "NeneFastStateMachine: add_state is not used with static handlers");
+        const std::size_t i = index_(id);
+        states_[i] = st;
+        registered_[i] = true;
+    }
+    bool has_state(StateId id) const {
+        const std::size_t i = static_cast<std::size_t>(id);
+        if (i >= StateCount) return false;
+        if constexpr (kStatic) return true;
+        else return registered_[i];
+    }
+    // 初期化（enter も呼ぶ）
+    void set_initial(StateId id, Context& ctx) {
+        ensure_state_(id);
+        current_ = id;
+        started_ = true;
+        call_enter_(id, ctx);
+    }
+    bool started() const { return started_; }
+    StateId current() const { return current_; }
+    // 強制遷移（exit->enter）. 遷移中の遷移要求は最後の1つを続けて処理する
+    void transition_to(StateId next, Context& ctx) {
+        ensure_state_(next);
+        if (!started_) {
+            set_initial(next, ctx);
+            return;
+        }
+        if (current_ == next) return;
+        pending_ = next;
+        has_pending_ = true;
+        if (in_transition_) return;
+        in_transition_ = true;
+        while (has_pending_) {
+            const StateId target = pending_;
+            has_pending_ = false;
+            call_exit_(current_, ctx);
+            current_ = target;
+            call_enter_(target, ctx);
+        }
+        in_transition_ = false;
+    }
+    // 更新
+    void update(Context& ctx, float dt) {
+        if (!started_) return;
+        Transition next;
+        if constexpr (kStatic) {
+            next = Handlers::on_update(current_, ctx, dt);
+        } else {
+            const auto fn = states_[static_cast<std::size_t>(current_)].on_update;
+            if (!fn) return;
+            next = fn(ctx, dt);
+        }
+        if (next) transition_to(*next, ctx);
+    }
+    // イベント投入
+    void dispatch(Context& ctx, const Event& ev) {
+        if (!started_) return;
+        Transition next;
+        if constexpr (kStatic) {
+            next = Handlers::on_event(current_, ctx, ev);
+        } else {
+            const auto fn = states_[static_cast<std::size_t>(current_)].on_event;
+            if (!fn) return;
+            next = fn(ctx, ev);
+        }
+        if (next) transition_to(*next, ctx);
+    }
+    void dispatch(Context& ctx) {
+        dispatch(ctx, Event{});
+    }
+private:
+    static std::size_t index_(StateId id) {
+        const std::size_t i = static_cast<std::size_t>(id);
+        if (i >= StateCount) throw std::runtime_error("NeneFastStateMachine: state out of range");
+        return i;
+    }
+    void ensure_state_(StateId id) const {
+        if (!has_state(id)) {
+            throw std::runtime_error("NeneFastStateMachine: unknown state");
+        }
+    }
     void call_enter_(StateId id, Context& ctx) {
-        State& st = state_ref_(id);
-        if (st.on_enter) st.on_enter(ctx);
+        if constexpr (kStatic) {
+            Handlers::on_enter(id, ctx);
+        } else {
+            if (const auto fn = states_[static_cast<std::size_t>(id)].on_enter) fn(ctx);
+        }
     }
     void call_exit_(StateId id, Context& ctx) {
-        State& st = state_ref_(id);
-        if (st.on_exit) st.on_exit(ctx);
+        if constexpr (kStatic) {
+            Handlers::on_exit(id, ctx);
+        } else {
+            if (const auto fn = states_[static_cast<std::size_t>(id)].on_exit) fn(ctx);
+        }
     }
 private:
-    std::unordered_map<StateId, State> states_;
-    std::optional<StateId> current_;
+    std::array<State, StateCount> states_{};
+    std::array<bool, StateCount> registered_{};
+    StateId current_{};
+    StateId pending_{};
     bool started_ = false;
+    bool has_pending_ = false;
     // 遷移の再入対策
     bool in_transition_ = false;
-    std::optional<StateId> pending_;
+};
+
+// 共有ステート定義（同じ振る舞いのエージェントを大量に動かす用）
+// 定義は組み立てたら shared_ptr<const> で共有し, エージェントごとには現在の状態と経過時間だけを持つ
+// on_update には状態に入ってからの経過時間 elapsed も渡す（タイマーを Context に持たなくてよい）
+template <class StateId, class Context, class Event = std::monostate,
+          std::size_t StateCount = static_cast<std::size_t>(StateId::Count)>
+class NeneStateDefinition {
+    static_assert(std::is_enum_v<StateId>, "NeneStateDefinition: StateId must be an enum");
+public:
+    using state_id_type = StateId;
+    using context_type = Context;
+    using event_type = Event;
+    using Transition = std::optional<StateId>;
+    struct State {
+        void (*on_enter)(Context&) = nullptr;
+        void (*on_exit)(Context&) = nullptr;
+        Transition (*on_update)(Context&, float dt, float elapsed) = nullptr;
+        Transition (*on_event)(Context&, const Event&) = nullptr;
+    };
+    // エージェントごとの状態（数バイト）
+    struct Agent {
+        StateId current{};
+        float elapsed = 0.0f;
+    };
+    static constexpr std::size_t state_count = StateCount;
+    // 状態登録（共有する前に済ませる）
+    NeneStateDefinition& add_state(StateId id, State st) {
+        const std::size_t i = static_cast<std::size_t>(id);
+        if (i >= StateCount) throw std::runtime_error("NeneStateDefinition: state out of range");
+        states_[i] = st;
+        registered_[i] = true;
+        return *this;
+    }
+    bool has_state(StateId id) const {
+        const std::size_t i = static_cast<std::size_t>(id);
+        return i < StateCount && registered_[i];
+    }
+    const State& state(StateId id) const {
+        return states_[static_cast<std::size_t>(id)];
+    }
+    // エージェント開始（enter も呼ぶ）
+    Agent start(StateId id, Context& ctx) const {
+        ensure_state_(id);
+        Agent a;
+        a.current = id;
+        if (const auto fn = state(id).on_enter) fn(ctx);
+        return a;
+    }
+    // 強制遷移（exit->enter）. enter/exit の中から遷移させたい場合は update/dispatch で返す
+    void transition(Agent& a, StateId next, Context& ctx) const {
+        ensure_state_(next);
+        if (a.current == next) return;
+        if (const auto fn = state(a.current).on_exit) fn(ctx);
+        a.current = next;
+        a.elapsed = 0.0f;
+        if (const auto fn = state(next).on_enter) fn(ctx);
+    }
+    // 1体だけ更新
+    void update(Agent& a, Context& ctx, float dt) const {
+        a.elapsed += dt;
+        const auto fn = state(a.current).on_update;
+        if (!fn) return;
+        if (auto next = fn(ctx, dt, a.elapsed)) transition(a, *next, ctx);
+    }
+    void dispatch(Agent& a, Context& ctx, const Event& ev) const {
+        const auto fn = state(a.current).on_event;
+        if (!fn) return;
+        if (auto next = fn(ctx, ev)) transition(a, *next, ctx);
+    }
+private:
+    void ensure_state_(StateId id) const {
+        if (!has_state(id)) {
+            throw std::runtime_error("NeneStateDefinition: unknown state");
+        }
+    }
+private:
+    std::array<State, StateCount> states_{};
+    std::array<bool, StateCount> registered_{};
+};
+
+// ステート定義を共有するエージェント群
+// contexts[i] と i 番目のエージェントが対応する（追加・削除は呼び出し側の配列と同じ順で行う）
+// update では現在の状態ごとにエージェントをまとめ, 状態ごとに同じハンドラを続けて呼ぶ
+template <class Definition>
+class NeneStateBatch {
+public:
+    using StateId = typename Definition::state_id_type;
+    using Context = typename Definition::context_type;
+    using Event = typename Definition::event_type;
+    using Agent = typename Definition::Agent;
+
+    explicit NeneStateBatch(std::shared_ptr<const Definition> def)
+        : def_(std::move(def)) {
+        if (!def_) throw std::runtime_error("NeneStateBatch: definition is null");
+    }
+    const Definition& definition() const { return *def_; }
+    // エージェント追加（enter も呼ぶ）. 戻り値は添字
+    std::size_t add(StateId initial, Context& ctx) {
+        agents_.push_back(def_->start(initial, ctx));
+        return agents_.size() - 1;
+    }
+    // 末尾と入れ替えて削除（contexts 側も同じように消すこと）
+    void swap_remove(std::size_t i) {
+        if (i >= agents_.size()) return;
+        agents_[i] = agents_.back();
+        agents_.pop_back();
+    }
+    void clear() { agents_.clear(); }
+    std::size_t size() const { return agents_.size(); }
+    const Agent& agent(std::size_t i) const { return agents_[i]; }
+    StateId current(std::size_t i) const { return agents_[i].current; }
+    void transition(std::size_t i, StateId next, Context& ctx) {
+        def_->transition(agents_[i], next, ctx);
+    }
+    void dispatch(std::size_t i, Context& ctx, const Event& ev) {
+        def_->dispatch(agents_[i], ctx, ev);
+    }
+    // 一括更新. このフレームで遷移したエージェントは遷移先のハンドラを次のフレームから呼ぶ
+    // contexts は std::vector<Context> をそのまま渡せる
+    void update(std::span<Context> contexts, float dt) {
+        if (contexts.size() != agents_.size()) {
+            throw std::runtime_error("NeneStateBatch: contexts size mismatch");
+        }
+        constexpr std::size_t N = Definition::state_count;
+        // 状態ごとの個数 -> 開始位置
+        std::array<std::uint32_t, N + 1> offsets{};
+        for (const Agent& a : agents_) offsets[static_cast<std::size_t>(a.current) + 1]++;
+        for (std::size_t s = 0; s < N; ++s) offsets[s + 1] += offsets[s];
+        order_.resize(agents_.size());
+        std::array<std::uint32_t, N> cursor{};
+        for (std::size_t s = 0; s < N; ++s) cursor[s] = offsets[s];
+        for (std::uint32_t i = 0; i < (std::uint32_t)agents_.size(); ++i) {
+            order_[cursor[static_cast<std::size_t>(agents_[i].current)]++] = i;
+        }
+        // 状態ごとに連続して回す
+        for (std::size_t s = 0; s < N; ++s) {
+            const std::uint32_t begin = offsets[s];
+            const std::uint32_t end = offsets[s + 1];
+            if (begin == end) continue;
+            const auto fn = def_->state(static_cast<StateId>(s)).on_update;
+            for (std::uint32_t k = begin; k < end; ++k) {
+                Agent& a = agents_[order_[k]];
+                a.elapsed += dt;
+                if (!fn) continue;
+                Context& ctx = contexts[order_[k]];
+                if (auto next = fn(ctx, dt, a.elapsed)) def_->transition(a, *next, ctx);
+            }
+        }
+    }
+private:
+    std::shared_ptr<const Definition> def_;
+    std::vector<Agent> agents_;
+    // 状態でまとめた添字（毎フレーム使い回す）
+    std::vector<std::uint32_t> order_;
+};
+
+// 乱数生成器（xoshiro128**. 状態 16 バイトで mt19937 より速い）
+// UniformRandomBitGenerator なので std の分布にもそのまま渡せる
+class NeneRng {
+public:
+    using result_type = std::uint32_t;
+    NeneRng() : NeneRng(0) {}
+    explicit NeneRng(std::uint64_t seed) { reseed(seed); }
+    // splitmix64 で状態を埋める（種が近くても系列は離れる）
+    void reseed(std::uint64_t seed) {
+        const std::uint64_t a = splitmix64(seed);
+        const std::uint64_t b = splitmix64(seed);
+        s_[0] = static_cast<std::uint32_t>(a);
+        s_[1] = static_cast<std::uint32_t>(a >> 32);
+        s_[2] = static_cast<std::uint32_t>(b);
+        s_[3] = static_cast<std::uint32_t>(b >> 32);
+        if ((s_[0] | s_[1] | s_[2] | s_[3]) == 0) s_[0] = 1; // 全部 0 だと止まる
+    }
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+    result_type operator()() { return next_u32(); }
+    std::uint32_t next_u32() {
+        const std::uint32_t result = rotl_(s_[1] * 5u, 7) * 9u;
+        const std::uint32_t t = s_[1] << 9;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl_(s_[3], 11);
+        return result;
+    }
+    // [0, 1)
+    float next_float() { return static_cast<float>(next_u32() >> 8) * (1.0f / 16777216.0f); }
+    // [a, b)
+    float uniform(float a, float b) { return a + (b - a) * next_float(); }
+    // [lo, hi]（掛け算で縮めるので偏りは 2^-32 程度）
+    int range(int lo, int hi) {
+        if (hi <= lo) return lo;
+        const std::uint64_t span = static_cast<std::uint64_t>(static_cast<std::int64_t>(hi) - lo) + 1;
+        return static_cast<int>(lo + static_cast<std::int64_t>((static_cast<std::uint64_t>(next_u32()) * span) >> 32));
+    }
+    bool chance(float p) { return next_float() < p; }
+    // まとめて埋める（パーティクルなど）
+    void fill_uniform(std::span<float> out, float a, float b) {
+        const float scale = (b - a) * (1.0f / 16777216.0f);
+        for (float& v : out) v = a + static_cast<float>(next_u32() >> 8) * scale;
+    }
+    void fill_u32(std::span<std::uint32_t> out) {
+        for (std::uint32_t& v : out) v = next_u32();
+    }
+    // 種の撹拌（ストリームの導出にも使う）
+    static std::uint64_t splitmix64(std::uint64_t& x) {
+        std::uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+private:
+    static std::uint32_t rotl_(std::uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+    std::uint32_t s_[4]{};
+};
+
+// 時間管理装置（階層タイマーホイール）
+// advance(dt) で時計を進め, 期限が来たものだけまとめて呼ぶ（タイマーの総数ではなく期限が来た数に比例）
+// 時計は advance を呼んだ分しか進まないので, 呼ばなければ止まる
+// owner を付けたタイマーは cancel_owner でまとめて消せる
+// 持ち主ごとに止まっていた時間（skipped）を数えてもらえば, その分だけ期限を後ろへずらす（止まっている間は進まない）
+// ずらすのは期限が来たときだけなので, 止まっている持ち主のタイマーがあっても毎フレームの手間は増えない
+using NeneTimerId = std::uint64_t; // 0 は無効
+class NeneTimer {
+public:
+    // 持ち主の様子（advance に渡す clock(owner) が返す）
+    struct OwnerClock {
+        bool paused = false;  // 今止まっているか
+        double skipped = 0.0; // これまでに止まっていた時間の合計（sec. 減らないこと）
+    };
+    explicit NeneTimer(float tick_sec = 0.001f) : tick_sec_(tick_sec > 0.0f ? tick_sec : 0.001f) {}
+    // 一回だけ（owner_skipped は登録時点の持ち主の skipped）
+    NeneTimerId after(float sec, std::function<void()> fn, const void* owner = nullptr, double owner_skipped = 0.0) {
+        return add_(to_ticks_(sec), 0, std::move(fn), owner, owner_skipped);
+    }
+    // 繰り返し（最初は sec 後）
+    NeneTimerId every(float sec, std::function<void()> fn, const void* owner = nullptr, double owner_skipped = 0.0) {
+        const std::uint64_t period = to_ticks_(sec);
+        return add_(period, period, std::move(fn), owner, owner_skipped);
+    }
+    // 取り消し（コールバックの中から自分を消してもよい）
+    bool cancel(NeneTimerId id) {
+        const std::uint32_t i = index_of_(id);
+        if (i == kNil) return false;
+        deactivate_(i);
+        return true;
+    }
+    // owner のタイマーを全部取り消す. 消した数を返す
+    std::size_t cancel_owner(const void* owner) {
+        auto it = owner_head_.find(owner);
+        if (it == owner_head_.end()) return 0;
+        std::size_t n = 0;
+        while (it != owner_head_.end()) { // deactivate_ が先頭を外していく
+            deactivate_(it->second);
+            ++n;
+            it = owner_head_.find(owner);
+        }
+        return n;
+    }
+    bool pending(NeneTimerId id) const { return index_of_(id) != kNil; }
+    // 全部取り消して時計も 0 に戻す（コールバックの中から呼んだら, 時計を戻すのは advance の最後）
+    void clear() {
+        for (std::uint32_t i = 0; i < entries_.size(); ++i) deactivate_(i);
+        if (advancing_) clear_pending_ = true;
+        else restart_();
+    }
+    std::size_t size() const { return active_count_; }
+    // 経過時間（sec）
+    float now() const { return static_cast<float>(now_) * tick_sec_; }
+    // 時計を進めて期限が来たものを呼ぶ
+    void advance(float dt) {
+        advance(dt, [](const void*) { return OwnerClock{}; });
+    }
+    template <class Clock>
+    void advance(float dt, Clock&& clock) {
+        if (advancing_) return; // コールバックの中からは進めない
+        advancing_ = true;
+        struct Guard {
+            NeneTimer* self;
+            ~Guard() {
+                self->advancing_ = false;
+                if (self->clear_pending_) self->restart_();
+            }
+        } guard{this};
+        // 期限の瞬間に持ち主が止まっていたもの（止まっていた時間が分かったのでずらし直す）
+        if (!held_.empty()) {
+            std::vector<std::uint32_t> held;
+            held.swap(held_);
+            for (std::uint32_t i : held) {
+                if (!entries_[i].active) release_(i);
+                else settle_(i, clock, true);
+            }
+        }
+        acc_ += dt / tick_sec_;
+        if (acc_ < 1.0f) return;
+        std::uint64_t ticks = static_cast<std::uint64_t>(acc_);
+        acc_ -= static_cast<float>(ticks);
+        while (ticks-- > 0) {
+            if (clear_pending_) return;
+            // ホイールに何も無ければ空回りしない
+            if (linked_count_ == 0) {
+                now_ += ticks + 1;
+                return;
+            }
+            tick_(clock);
+        }
+    }
+private:
+    static constexpr std::uint32_t kNil = std::numeric_limits<std::uint32_t>::max();
+    static constexpr int kBits = 6;
+    static constexpr std::uint32_t kSlots = 1u << kBits;
+    static constexpr std::uint32_t kMask = kSlots - 1;
+    static constexpr int kLevels = 4;
+    struct Entry {
+        std::uint64_t expire = 0;
+        std::uint64_t period = 0; // 0 なら一回だけ
+        std::function<void()> fn;
+        const void* owner = nullptr;
+        double skipped_base = 0.0;       // 期限に織り込み済みの持ち主の skipped
+        std::uint32_t next = kNil;       // ホイールのスロット内の次
+        std::uint32_t owner_prev = kNil; // 同じ持ち主の前後
+        std::uint32_t owner_next = kNil;
+        std::uint32_t generation = 0;
+        bool active = false;
+    };
+    std::uint64_t to_ticks_(float sec) const {
+        const double t = std::ceil(static_cast<double>(sec) / tick_sec_ - 1e-4);
+        return t < 1.0 ? 1 : static_cast<std::uint64_t>(t);
+    }
+    std::uint32_t index_of_(NeneTimerId id) const {
+        const std::uint32_t i = static_cast<std::uint32_t>(id & 0xffffffffu);
+        if (i == 0 || i > entries_.size()) return kNil;
+        const Entry& e = entries_[i - 1];
+        if (!e.active || e.generation != static_cast<std::uint32_t>(id >> 32)) return kNil;
+        return i - 1;
+    }
+    NeneTimerId add_(std::uint64_t delay, std::uint64_t period, std::function<void()> fn, const void* owner, double owner_skipped) {
+        std::uint32_t i;
+        if (!free_.empty()) {
+            i = free_.back();
+            free_.pop_back();
+        } else {
+            i = static_cast<std::uint32_t>(entries_.size());
+            entries_.emplace_back();
+        }
+        Entry& e = entries_[i];
+        e.expire = now_ + delay - 1; // now_ 番目のティックで期限なら次の tick_ で呼ばれる
+        e.period = period;
+        e.fn = std::move(fn);
+        e.active = true;
+        e.owner = owner;
+        e.skipped_base = owner_skipped;
+        e.owner_prev = kNil;
+        e.owner_next = kNil;
+        if (owner) {
+            auto [it, inserted] = owner_head_.try_emplace(owner, i);
+            if (!inserted) {
+                e.owner_next = it->second;
+                entries_[it->second].owner_prev = i;
+                it->second = i;
+            }
+        }
+        ++active_count_;
+        link_(i);
+        return (static_cast<NeneTimerId>(e.generation) << 32) | (i + 1);
+    }
+    // 期限までの距離で段を選んで差し込む
+    void link_(std::uint32_t i) {
+        Entry& e = entries_[i];
+        const std::uint64_t expire = e.expire < now_ ? now_ : e.expire;
+        const std::uint64_t delta = expire - now_;
+        int level = 0;
+        while (level + 1 < kLevels && delta >= (std::uint64_t(1) << (kBits * (level + 1)))) ++level;
+        // 一番上の段にも収まらないものは, 一周した後にもう一度差し直す
+        const std::uint64_t span = std::uint64_t(1) << (kBits * kLevels);
+        const std::uint64_t at = delta >= span ? now_ + span - 1 : expire;
+        std::uint32_t& head = wheel_[level][(at >> (kBits * level)) & kMask];
+        e.next = head;
+        head = i;
+        ++linked_count_;
+    }
+    // 取り消し済みにする（ホイールや held_ からは, そこを通ったときに外す）
+    void deactivate_(std::uint32_t i) {
+        Entry& e = entries_[i];
+        if (!e.active) return;
+        e.active = false;
+        e.fn = nullptr;
+        --active_count_;
+        if (!e.owner) return;
+        if (e.owner_prev != kNil) entries_[e.owner_prev].owner_next = e.owner_next;
+        else if (e.owner_next != kNil) owner_head_[e.owner] = e.owner_next;
+        else owner_head_.erase(e.owner);
+        if (e.owner_next != kNil) entries_[e.owner_next].owner_prev = e.owner_prev;
+        e.owner = nullptr;
+        e.owner_prev = kNil;
+        e.owner_next = kNil;
+    }
+    void release_(std::uint32_t i) {
+        Entry& e = entries_[i];
+        e.fn = nullptr;
+        e.active = false;
+        ++e.generation;
+        free_.push_back(i);
+    }
+    // 時計を 0 に戻してホイールを組み直す
+    // clear の後に足されたものは残りの時間のまま差し直し, 取り消し済みは世代を進めて空きに戻す
+    void restart_() {
+        std::vector<bool> held(entries_.size(), false);
+        std::vector<std::uint32_t> keep;
+        for (std::uint32_t i : held_) {
+            if (entries_[i].active) {
+                held[i] = true;
+                keep.push_back(i);
+            }
+        }
+        held_.swap(keep);
+        for (auto& level : wheel_) level.fill(kNil);
+        linked_count_ = 0;
+        free_.clear();
+        const std::uint64_t base = now_;
+        now_ = 0;
+        acc_ = 0.0f;
+        clear_pending_ = false;
+        for (std::uint32_t i = 0; i < entries_.size(); ++i) {
+            Entry& e = entries_[i];
+            if (!e.active) {
+                e.fn = nullptr;
+                ++e.generation;
+                free_.push_back(i);
+                continue;
+            }
+            e.expire = e.expire >= base ? e.expire - base : 0;
+            if (!held[i]) link_(i);
+        }
+    }
+    // 期限が来たものを呼ぶ. 繰り返しなら次の期限で差し直す（rebase なら今から数え直す）
+    void fire_(std::uint32_t i, bool rebase) {
+        std::function<void()> fn = std::move(entries_[i].fn);
+        const bool repeat = entries_[i].period > 0;
+        const std::uint32_t generation = entries_[i].generation;
+        if (repeat) {
+            entries_[i].expire = (rebase ? now_ - 1 : entries_[i].expire) + entries_[i].period;
+            link_(i);
+        } else {
+            deactivate_(i);
+            release_(i);
+        }
+        if (fn) fn();
+        // 繰り返しで, コールバックの中で取り消されていなければ戻す
+        if (repeat && entries_[i].active && entries_[i].generation == generation) entries_[i].fn = std::move(fn);
+    }
+    // 期限が来たものの持ち主を見る. 止まっていた分だけ後ろへずらし, まだ先なら差し直す
+    // 今止まっていれば held_ に置いて次の advance で見直す（その間の止まっていた時間がまだ数えられていないため）
+    template <class Clock>
+    void settle_(std::uint32_t i, Clock& clock, bool rebase) {
+        if (entries_[i].owner) {
+            const OwnerClock st = clock(entries_[i].owner);
+            Entry& e = entries_[i];
+            const double skipped = (st.skipped - e.skipped_base) / tick_sec_;
+            if (skipped >= 1.0) {
+                const std::uint64_t d = static_cast<std::uint64_t>(skipped);
+                e.skipped_base += static_cast<double>(d) * tick_sec_;
+                e.expire += d;
+                if (e.expire >= now_) {
+                    link_(i);
+                    return;
+                }
+            }
+            if (st.paused) {
+                held_.push_back(i);
+                return;
+            }
+        }
+        fire_(i, rebase);
+    }
+    // 上の段のスロットを下の段へ配り直す
+    void cascade_(int level, std::uint32_t slot) {
+        std::uint32_t i = wheel_[level][slot];
+        wheel_[level][slot] = kNil;
+        while (i != kNil) {
+            const std::uint32_t next = entries_[i].next;
+            --linked_count_;
+            if (entries_[i].active) link_(i);
+            else release_(i);
+            i = next;
+        }
+    }
+    template <class Clock>
+    void tick_(Clock& clock) {
+        const std::uint32_t slot = static_cast<std::uint32_t>(now_ & kMask);
+        if (slot == 0) {
+            for (int level = 1; level < kLevels; ++level) {
+                const std::uint32_t s = static_cast<std::uint32_t>((now_ >> (kBits * level)) & kMask);
+                cascade_(level, s);
+                if (s != 0) break;
+            }
+        }
+        // 期限が来たリストを切り離してから呼ぶ（コールバック中の追加・取り消しに備える）
+        std::uint32_t i = wheel_[0][slot];
+        wheel_[0][slot] = kNil;
+        ++now_;
+        while (i != kNil) {
+            const std::uint32_t next = entries_[i].next;
+            --linked_count_;
+            if (!entries_[i].active) {
+                release_(i);
+            } else if (entries_[i].expire >= now_) {
+                // 一番上の段から一周して戻ってきた遠いタイマー
+                link_(i);
+            } else {
+                settle_(i, clock, false);
+            }
+            i = next;
+        }
+    }
+private:
+    float tick_sec_;
+    float acc_ = 0.0f;
+    std::uint64_t now_ = 0;
+    std::size_t active_count_ = 0;
+    std::size_t linked_count_ = 0; // ホイールに入っている数（取り消し済みも含む）
+    bool advancing_ = false;
+    bool clear_pending_ = false;
+    std::vector<Entry> entries_;
+    std::vector<std::uint32_t> free_;
+    std::vector<std::uint32_t> held_;
+    std::unordered_map<const void*, std::uint32_t> owner_head_;
+    std::array<std::array<std::uint32_t, kSlots>, kLevels> wheel_ = make_empty_wheel_();
+    static std::array<std::array<std::uint32_t, kSlots>, kLevels> make_empty_wheel_() {
+        std::array<std::array<std::uint32_t, kSlots>, kLevels> w{};
+        for (auto& level : w) level.fill(kNil);
+        return w;
+    }
 };
 
 // アニメーション制御装置
@@ -149,64 +990,358 @@ struct NeneAnimClip {
     std::string next = "";
 };
 
+using NeneAnimClipId = std::uint32_t;
+inline constexpr NeneAnimClipId kNeneNoClip = std::numeric_limits<NeneAnimClipId>::max();
+
+// クリップ置き場. 組み立てたら各 NeneAnimator にポインタで渡し, 参照させるだけ（ライブラリの方を長生きさせる）
+// 名前は登録時と play 時に一度だけ id に引く. フレームは全クリップ分を1本の配列に並べて持つ
+class NeneAnimClipLibrary {
+public:
+    struct ClipInfo {
+        std::uint32_t first = 0; // frames の開始位置
+        std::uint32_t count = 0;
+        float total = 0.0f;      // 1周の長さ
+        bool loop = true;
+        NeneAnimClipId next = kNeneNoClip;
+    };
+    // 登録（同じ名前なら上書き）. next は後から登録されるクリップでもよい
+    NeneAnimClipId add_clip(std::string name, NeneAnimClip clip) {
+        NeneAnimClipId id;
+        auto it = ids_.find(name);
+        if (it != ids_.end()) {
+            id = it->second;
+        } else {
+            id = (NeneAnimClipId)infos_.size();
+            infos_.emplace_back();
+            names_.push_back(name);
+            next_names_.emplace_back();
+            ids_.emplace(std::move(name), id);
+        }
+        ClipInfo& info = infos_[id];
+        // 上書き時は古いフレームを残したまま末尾に足す（組み立て時だけなので気にしない）
+        info.first = (std::uint32_t)srcs_.size();
+        info.count = (std::uint32_t)clip.frames.size();
+        info.loop = clip.loop;
+        info.total = 0.0f;
+        for (const NeneAnimFrame& f : clip.frames) {
+            srcs_.push_back(f.src);
+            // 0秒のフレームで無限ループしないように
+            durations_.push_back(std::max(f.duration, 1e-6f));
+            info.total += durations_.back();
+        }
+        next_names_[id] = std::move(clip.next);
+        resolve_next_();
+        return id;
+    }
+    // 見つからなければ kNeneNoClip
+    NeneAnimClipId id(std::string_view name) const {
+        auto it = ids_.find(std::string(name));
+        return it == ids_.end() ? kNeneNoClip : it->second;
+    }
+    const std::string& name(NeneAnimClipId id) const { return names_.at(id); }
+    std::size_t clip_count() const { return infos_.size(); }
+    const ClipInfo& info(NeneAnimClipId id) const { return infos_[id]; }
+    const SDL_FRect& frame_src(std::uint32_t frame) const { return srcs_[frame]; }
+    float frame_duration(std::uint32_t frame) const { return durations_[frame]; }
+private:
+    void resolve_next_() {
+        for (std::size_t i = 0; i < infos_.size(); ++i) {
+            infos_[i].next = next_names_[i].empty() ? kNeneNoClip : id(next_names_[i]);
+        }
+    }
+private:
+    std::unordered_map<std::string, NeneAnimClipId> ids_;
+    std::vector<ClipInfo> infos_;
+    std::vector<std::string> names_;
+    std::vector<std::string> next_names_;
+    std::vector<SDL_FRect> srcs_;
+    std::vector<float> durations_;
+};
+
+// 再生状態だけを持つ（数バイト）. ライブラリは animator より長生きさせること
 class NeneAnimator {
 public:
-    void add_clip(std::string name, NeneAnimClip clip) {
-        clips_.emplace(std::move(name), std::move(clip));
+    NeneAnimator() = default;
+    explicit NeneAnimator(const NeneAnimClipLibrary* library) : lib_(library) {}
+    void set_library(const NeneAnimClipLibrary* library) {
+        lib_ = library;
+        clip_ = kNeneNoClip;
     }
-    void play(std::string name, bool restart=false) {
-        if (!restart && current_ == name) return;
-        current_ = std::move(name);
+    const NeneAnimClipLibrary* library() const { return lib_; }
+    // 登録されていない id は kNeneNoClip（止める）として扱う
+    void play(NeneAnimClipId clip, bool restart=false) {
+        if (!lib_ || clip >= lib_->clip_count()) clip = kNeneNoClip;
+        if (!restart && clip_ == clip) return;
+        clip_ = clip;
         idx_ = 0;
         t_ = 0.0f;
         finished_ = false;
     }
+    // 名前で再生（毎フレーム呼ぶなら id を持っておく）
+    void play(std::string_view name, bool restart=false) {
+        play(lib_ ? lib_->id(name) : kNeneNoClip, restart);
+    }
     void set_speed(float s) { speed_ = s; } // 0で停止も可
+    float speed() const { return speed_; }
     void update(float dt) {
-        if (current_.empty()) return;
-        auto it = clips_.find(current_);
-        if (it == clips_.end()) return;
-        auto& clip = it->second;
-        if (clip.frames.empty()) return;
-        if (finished_) return;
-        float adv = dt * speed_;
+        if (clip_ == kNeneNoClip || finished_ || !lib_) return;
+        const NeneAnimClipLibrary::ClipInfo& clip = lib_->info(clip_);
+        if (clip.count == 0) return;
+        // 再生中のクリップが短く上書きされていたら最後のフレームに寄せる
+        if (idx_ >= clip.count) idx_ = clip.count - 1;
+        t_ += dt * speed_;
+        // ループ中で何周も進んだときは余りだけ見る
+        if (clip.loop && t_ >= clip.total) t_ = std::fmod(t_, clip.total);
         // dt が大きい時にフレーム飛びしても破綻しないよう while で進める
-        while (adv > 0.0f && !finished_) {
-            float dur = clip.frames[idx_].duration;
-            float remain = dur - t_;
-            if (adv < remain) {
-                t_ += adv;
-                adv = 0.0f;
-            } else {
-                adv -= remain;
-                t_ = 0.0f;
-                if (idx_ + 1 < (int)clip.frames.size()) {
-                    idx_++;
+        float dur = lib_->frame_duration(clip.first + idx_);
+        while (t_ >= dur) {
+            t_ -= dur;
+            if (++idx_ == clip.count) {
+                if (clip.loop) {
+                    idx_ = 0;
                 } else {
-                    if (clip.loop) {
-                        idx_ = 0;
-                    } else {
-                        finished_ = true;
-                        if (!clip.next.empty()) play(clip.next, true);
-                    }
+                    idx_ = clip.count - 1;
+                    t_ = 0.0f;
+                    finished_ = true;
+                    if (clip.next != kNeneNoClip) play(clip.next, true);
+                    return;
                 }
             }
+            dur = lib_->frame_duration(clip.first + idx_);
         }
     }
     const SDL_FRect* src() const {
-        auto it = clips_.find(current_);
-        if (it == clips_.end()) return nullptr;
-        auto& clip = it->second;
-        if (clip.frames.empty()) return nullptr;
-        return &clip.frames[idx_].src;
+        if (clip_ == kNeneNoClip || !lib_) return nullptr;
+        const NeneAnimClipLibrary::ClipInfo& clip = lib_->info(clip_);
+        if (clip.count == 0) return nullptr;
+        return &lib_->frame_src(clip.first + std::min(idx_, clip.count - 1));
     }
     bool finished() const { return finished_; }
-    const std::string& current() const { return current_; }
+    NeneAnimClipId current() const { return clip_; }
+    std::uint32_t frame_index() const { return idx_; }
 private:
-    std::unordered_map<std::string, NeneAnimClip> clips_;
-    std::string current_;
-    int idx_ = 0;
+    const NeneAnimClipLibrary* lib_ = nullptr;
+    NeneAnimClipId clip_ = kNeneNoClip;
+    std::uint32_t idx_ = 0;
     float t_ = 0.0f;
     float speed_ = 1.0f;
     bool finished_ = false;
 };
+
+// エンティティ（下位 24 ビットが番号, 上位 8 ビットが世代. 番号を使い回しても古い ID は無効になる）
+using NeneEntity = std::uint32_t;
+inline constexpr NeneEntity kNeneNoEntity = 0xFFFFFFFFu;
+inline constexpr std::uint32_t nene_entity_index(NeneEntity e) { return e & 0x00FFFFFFu; }
+inline constexpr std::uint32_t nene_entity_generation(NeneEntity e) { return e >> 24; }
+
+// コンポーネント置き場の共通部分（エンティティを消すとき, 型を知らなくても外せるように）
+class NeneComponentPoolBase {
+public:
+    virtual ~NeneComponentPoolBase() = default;
+    virtual bool remove(NeneEntity e) = 0;
+    virtual void clear() = 0;
+};
+
+// コンポーネント置き場（疎集合. 型ごとに1つ）
+// sparse_[番号] が詰めた配列の添字. 中身は data_ に隙間なく並ぶので data() を頭から回せば全部に触れる
+// 外すときは末尾と入れ替えるので順番は変わる
+template <class T>
+class NeneComponentPool final : public NeneComponentPoolBase {
+public:
+    template <class... Args>
+    T& emplace(NeneEntity e, Args&&... args) {
+        const std::uint32_t i = nene_entity_index(e);
+        if (i >= sparse_.size()) sparse_.resize(static_cast<std::size_t>(i) + 1, kNone);
+        std::uint32_t& d = sparse_[i];
+        if (d != kNone) {
+            // 付いていれば上書き
+            entities_[d] = e;
+            data_[d] = make_(std::forward<Args>(args)...);
+            return data_[d];
+        }
+        d = static_cast<std::uint32_t>(data_.size());
+        entities_.push_back(e);
+        data_.push_back(make_(std::forward<Args>(args)...));
+        return data_.back();
+    }
+    bool has(NeneEntity e) const { return dense_(e) != kNone; }
+    T* get(NeneEntity e) {
+        const std::uint32_t d = dense_(e);
+        return d == kNone ? nullptr : &data_[d];
+    }
+    const T* get(NeneEntity e) const {
+        const std::uint32_t d = dense_(e);
+        return d == kNone ? nullptr : &data_[d];
+    }
+    bool remove(NeneEntity e) override {
+        const std::uint32_t d = dense_(e);
+        if (d == kNone) return false;
+        const std::uint32_t last = static_cast<std::uint32_t>(data_.size() - 1);
+        if (d != last) {
+            data_[d] = std::move(data_[last]);
+            entities_[d] = entities_[last];
+            sparse_[nene_entity_index(entities_[d])] = d;
+        }
+        data_.pop_back();
+        entities_.pop_back();
+        sparse_[nene_entity_index(e)] = kNone;
+        return true;
+    }
+    void clear() override {
+        for (NeneEntity e : entities_) sparse_[nene_entity_index(e)] = kNone;
+        data_.clear();
+        entities_.clear();
+    }
+    std::size_t size() const { return data_.size(); }
+    // 詰めた配列（data()[i] の持ち主は entities()[i]）
+    std::span<T> data() { return data_; }
+    std::span<const T> data() const { return data_; }
+    std::span<const NeneEntity> entities() const { return entities_; }
+    void reserve(std::size_t n) {
+        data_.reserve(n);
+        entities_.reserve(n);
+    }
+private:
+    static constexpr std::uint32_t kNone = 0xFFFFFFFFu;
+    template <class... Args>
+    static T make_(Args&&... args) {
+        if constexpr (std::is_constructible_v<T, Args...>) return T(std::forward<Args>(args)...);
+        else return T{ std::forward<Args>(args)... }; // 集成体
+    }
+    std::uint32_t dense_(NeneEntity e) const {
+        const std::uint32_t i = nene_entity_index(e);
+        if (i >= sparse_.size()) return kNone;
+        const std::uint32_t d = sparse_[i];
+        return (d != kNone && entities_[d] == e) ? d : kNone;
+    }
+    std::vector<std::uint32_t> sparse_;
+    std::vector<NeneEntity> entities_;
+    std::vector<T> data_;
+};
+
+// エンティティとコンポーネントの置き場（大量の単純な物体をノードにせずに持つ用）
+// each<A, B...>(f) は A の詰めた配列を頭から回し, B... も持つものだけ f(e, a, b...) を呼ぶ（A には一番少ない型を選ぶ）
+// each の中で destroy や emplace/remove をすると配列がずれるので, 消すときは destroy_later を使う
+class NeneRegistry {
+public:
+    NeneEntity create() {
+        std::uint32_t i = 0;
+        if (!free_.empty()) {
+            i = free_.back();
+            free_.pop_back();
+        } else {
+            if (gen_.size() > kIndexMask) throw std::runtime_error("NeneRegistry: too many entities");
+            i = static_cast<std::uint32_t>(gen_.size());
+            gen_.push_back(0);
+        }
+        ++alive_;
+        return (static_cast<NeneEntity>(gen_[i]) << 24) | i;
+    }
+    bool alive(NeneEntity e) const {
+        const std::uint32_t i = nene_entity_index(e);
+        return e != kNeneNoEntity && i < gen_.size() && gen_[i] == nene_entity_generation(e);
+    }
+    bool destroy(NeneEntity e) {
+        if (!alive(e)) return false;
+        for (auto& p : pools_) {
+            if (p) p->remove(e);
+        }
+        const std::uint32_t i = nene_entity_index(e);
+        gen_[i] = static_cast<std::uint8_t>(gen_[i] + 1);
+        free_.push_back(i);
+        --alive_;
+        return true;
+    }
+    // each の中から消すとき用. flush でまとめて消す
+    void destroy_later(NeneEntity e) { pending_.push_back(e); }
+    void flush() {
+        for (NeneEntity e : pending_) destroy(e);
+        pending_.clear();
+    }
+    void clear() {
+        for (auto& p : pools_) {
+            if (p) p->clear();
+        }
+        // 世代は残して生きていた番号だけ進める（clear 前の ID が使い回しで生き返らないように）
+        std::vector<bool> freed(gen_.size(), false);
+        for (std::uint32_t i : free_) freed[i] = true;
+        free_.clear();
+        for (std::uint32_t i = static_cast<std::uint32_t>(gen_.size()); i-- > 0;) {
+            if (!freed[i]) gen_[i] = static_cast<std::uint8_t>(gen_[i] + 1);
+            free_.push_back(i); // 小さい番号から使い回す
+        }
+        pending_.clear();
+        alive_ = 0;
+    }
+    std::size_t size() const { return alive_; }
+    // コンポーネント
+    template <class T, class... Args>
+    T& emplace(NeneEntity e, Args&&... args) {
+        if (!alive(e)) throw std::runtime_error("NeneRegistry: entity is not alive");
+        return pool<T>().emplace(e, std::forward<Args>(args)...);
+    }
+    template <class T>
+    T* get(NeneEntity e) {
+        NeneComponentPool<T>* p = find_<T>();
+        return p ? p->get(e) : nullptr;
+    }
+    template <class T>
+    bool has(NeneEntity e) const {
+        const NeneComponentPool<T>* p = find_<T>();
+        return p && p->has(e);
+    }
+    template <class T>
+    bool remove(NeneEntity e) {
+        NeneComponentPool<T>* p = find_<T>();
+        return p && p->remove(e);
+    }
+    // 型ごとの置き場（無ければ作る）. data() を直接回すのが一番速い
+    template <class T>
+    NeneComponentPool<T>& pool() {
+        const std::size_t id = type_id_<T>();
+        if (id >= pools_.size()) pools_.resize(id + 1);
+        if (!pools_[id]) pools_[id] = std::make_unique<NeneComponentPool<T>>();
+        return static_cast<NeneComponentPool<T>&>(*pools_[id]);
+    }
+    template <class T, class... Others, class F>
+    void each(F&& f) {
+        NeneComponentPool<T>* p = find_<T>();
+        if (!p) return;
+        const std::span<const NeneEntity> es = p->entities();
+        const std::span<T> ds = p->data();
+        if constexpr (sizeof...(Others) == 0) {
+            for (std::size_t i = 0; i < ds.size(); ++i) f(es[i], ds[i]);
+        } else {
+            const std::tuple<NeneComponentPool<Others>*...> others{ find_<Others>()... };
+            if (((std::get<NeneComponentPool<Others>*>(others) == nullptr) || ...)) return;
+            for (std::size_t i = 0; i < ds.size(); ++i) {
+                const NeneEntity e = es[i];
+                if (!(std::get<NeneComponentPool<Others>*>(others)->has(e) && ...)) continue;
+                f(e, ds[i], *std::get<NeneComponentPool<Others>*>(others)->get(e)...);
+            }
+        }
+    }
+private:
+    static constexpr std::size_t kIndexMask = 0x00FFFFFFu;
+    // 型ごとの通し番号（最初に使ったときに決まる）
+    static std::size_t next_type_id_() {
+        static std::atomic<std::size_t> next{ 0 };
+        return next.fetch_add(1);
+    }
+    template <class T>
+    static std::size_t type_id_() {
+        static const std::size_t id = next_type_id_();
+        return id;
+    }
+    template <class T>
+    NeneComponentPool<T>* find_() const {
+        const std::size_t id = type_id_<T>();
+        if (id >= pools_.size() || !pools_[id]) return nullptr;
+        return static_cast<NeneComponentPool<T>*>(pools_[id].get());
+    }
+    std::vector<std::unique_ptr<NeneComponentPoolBase>> pools_;
+    std::vector<std::uint8_t> gen_;
+    std::vector<std::uint32_t> free_;
+    std::vector<NeneEntity> pending_;
+    std::size_t alive_ = 0;
+};
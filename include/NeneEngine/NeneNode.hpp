@@ -6,6 +6,7 @@
 #include <string_view>
 #include <map>
 #include <unordered_map>
+#include <unordered_set>
 #include <SDL3/SDL.h>
 #include <NeneEngine/NeneServer.hpp>
 
@@ -14,17 +15,30 @@ class NeneNode {
 public:
     std::string name;
     explicit NeneNode(std::string);
-    virtual ~NeneNode() = default;
+    virtual ~NeneNode(); // →.cpp
     void set_valve_sdl_event(bool v)   { valve_sdl_event = v; }
+    void set_valve_input(bool v)       { valve_input = v; }
     void set_valve_time_lapse(bool v)  { valve_time_lapse = v; }
     void set_valve_nene_mail(bool v)   { valve_nene_mail = v; }
     void set_valve_render(bool v)      { valve_render = v; }
     void set_active(bool v) {
         set_valve_sdl_event(v);
+        set_valve_input(v);
         set_valve_time_lapse(v);
         set_valve_nene_mail(v);
         set_valve_render(v);
     }
+    // 枝ごと描画から外す（NeneSwitch が裏に置いたシーンに使う. valve_render はそのノードだけ）
+    void set_parked(bool v) {
+        if (parked_ == v) return;
+        parked_ = v;
+        mark_render_dirty();
+    }
+    bool parked() const { return parked_; }
+    // 自分か祖先のどこかで time_lapse の水門が閉じている（タイマーとアニメーションはこの枝の分を止める）
+    bool time_paused() const; // →.cpp
+    // 自分と祖先の水門で止まっていた時間の合計（sec. タイマーの期限をこの分ずらす）
+    double time_skipped() const; // →.cpp
     // dirty伝播
     void set_render_z(int z) {
         if (render_z == z) return;
@@ -32,15 +46,24 @@ public:
         mark_render_dirty();
     }
     int  get_render_z() const { return render_z; }
+    // 子のサブツリー同士が独立なら time_lapse を worker_pool で並列に回す
+    // 並列中の send_mail / set_collider_position / set_render_z / cancel_timer / clear_timers は子の順番で同期点に反映する
+    // set_timeout / set_interval と, 共有サービスの登録・読み込み（黒板のキー, コライダーやアニメーションの追加, 画像・フォント, 乱数の shared）は throw
+    // 子が黒板に書くなら黒板をダブルバッファにしておくこと（しないと throw）
+    // 配る手間は毎フレームかかるので, 子の更新が重いときだけ使う
+    void set_children_independent(bool v) { children_independent_ = v; }
+    bool children_independent() const { return children_independent_; }
 protected:
     void show_tree(std::ostream& os = std::cout) const;
     // イベントパルス
     void pulse_sdl_event(const SDL_Event&);   // →.cpp
+    void pulse_input(const NeneInput&);       // →.cpp
     void pulse_time_lapse(const float&);      // →.cpp
     void pulse_nene_mail(const NeneMail&);    // →.cpp
     void pulse_render(SDL_Renderer*);         // →.cpp
     // 水門(パルスを遮断する)
     bool valve_sdl_event = true;
+    bool valve_input = true;
     bool valve_time_lapse = true;
     bool valve_nene_mail = true;
     bool valve_render = true;
@@ -53,6 +76,12 @@ protected:
     std::shared_ptr<PathService> path_service;
     std::shared_ptr<NeneBlackboard> blackboard;
     std::shared_ptr<NeneCollisionWorld> collision_world;
+    std::shared_ptr<NeneCamera> camera;
+    std::shared_ptr<NeneWorkerPool> worker_pool;
+    std::shared_ptr<NeneAnimationSystem> animation;
+    std::shared_ptr<NeneTimer> timer;
+    std::shared_ptr<NeneInput> input;
+    std::shared_ptr<NeneRandom> random;
     // 親ノード
     NeneNode* parent = nullptr;
     // 子ノード
@@ -61,34 +90,100 @@ protected:
     virtual void init_node() {}
     // イベントパルスの前方フック
     virtual void handle_sdl_event(const SDL_Event&) {}
+    // SDLイベントを翻訳したアクションの状態（1フレームに1回. time_lapse の前）
+    virtual void handle_input(const NeneInput&) {}
     virtual void handle_time_lapse(const float&) {}
     virtual void handle_nene_mail(const NeneMail&) {}
     virtual void render(SDL_Renderer*) {}
-    // dirty伝播
+    // 描画範囲（ワールド座標のAABB）. trueを返したノードは画面外のときrenderが呼ばれない
+    virtual bool render_bounds(SDL_FRect&) const { return false; }
+    // 作り直さずにその場で初期状態へ戻す（対応したノードだけ true を返す. NeneSwitch のやり直しで使う）
+    virtual bool reset_node() { return false; }
+    // 子のリセット（全員が対応していれば true）
+    bool reset_child(const std::string& name) {
+        auto it = children.find(name);
+        return it != children.end() && it->second && it->second->reset_node();
+    }
+    bool reset_children() {
+        bool all = true;
+        for (auto& kv : children) {
+            if (kv.second && !kv.second->reset_node()) all = false;
+        }
+        return all;
+    }
+    // dirty伝播（並列パルス中は祖先に触らず同期点まで遅らせる）
     void mark_render_dirty() {
+        if (in_parallel_()) {
+            defer_render_dirty_();
+            return;
+        }
         render_cache_dirty_ = true;
         if (parent) parent->mark_render_dirty();
     }
-    // 親子付け
+    // 親子付け（パルスの最中に呼ぶと, そのパルスが終わってからまとめて反映される）
     virtual void add_child(std::unique_ptr<NeneNode>); // →.cpp
     bool remove_child(const std::string& name); // →.cpp
     void clear_children(); // →.cpp
+    // ワールド座標で描画（カメラの変換を通す. カメラが無ければそのまま）
+    void draw_texture(SDL_Renderer* r, SDL_Texture* tex, const SDL_FRect* src, const SDL_FRect& dst_world) const {
+        const SDL_FRect dst = camera ? camera->to_screen(dst_world) : dst_world;
+        SDL_RenderTexture(r, tex, src, &dst);
+    }
     // ノードからメール送信
-    void send_mail(const NeneMail& mail) {
-        if (mail_server) mail_server->push(mail);
+    void send_mail(const NeneMail& mail) { send_mail(NeneMail(mail)); }
+    void send_mail(NeneMail&& mail); // →.cpp
+    // コライダーの位置を更新（並列パルス中は同期点まで遅らせる）
+    void set_collider_position(NeneCollisionWorld::ColliderId id, SDL_FPoint pos); // →.cpp
+    // タイマー（木に1つのホイールを一番上の time_lapse パルスで進める. 水門が閉じていた間は進まない）
+    // 並列パルス中は登録できない. 取り消しは同期点まで遅らせる（cancel_timer はまだ残っているかを返す）
+    NeneTimerId set_timeout(float sec, std::function<void()> fn); // →.cpp
+    NeneTimerId set_interval(float sec, std::function<void()> fn); // →.cpp
+    NeneTimerId send_mail_after(float sec, NeneMail mail) {
+        return set_timeout(sec, [this, mail = std::move(mail)] { send_mail(mail); });
     }
-    void send_mail(NeneMail&& mail) {
-        if (mail_server) mail_server->push(std::move(mail));
+    NeneTimerId send_mail_every(float sec, NeneMail mail) {
+        return set_interval(sec, [this, mail = std::move(mail)] { send_mail(mail); });
     }
+    bool cancel_timer(NeneTimerId id); // →.cpp
+    void clear_timers(); // →.cpp
     // ターミナル出力
     void nnlog(std::string_view msg) const; // →.cpp
     void nnerr(std::string_view msg) const; // →.cpp
     void nnthrow(std::string_view msg) const; // →.cpp
 private:
+    // パルス中（木の変更）/並列パルス中（メール・コライダー・描画順・タイマーの取り消し）に遅らせる操作
+    struct Command {
+        enum class Kind : std::uint8_t { Mail, AddChild, RemoveChild, ClearChildren, ColliderPosition, RenderDirty, CancelTimer, ClearTimers };
+        Command(Kind k, NeneNode* t) : kind(k), target(t) {}
+        Kind kind;
+        NeneNode* target = nullptr;
+        NeneMail mail;
+        std::unique_ptr<NeneNode> node;
+        std::string name;
+        NeneCollisionWorld::ColliderId collider = 0;
+        SDL_FPoint position{ 0.0f, 0.0f };
+        NeneTimerId timer_id = 0;
+    };
+    static std::vector<Command>*& deferred_commands_(); // →.cpp（このスレッドの積み先. パルス中だけ非null）
+    static bool& in_parallel_(); // →.cpp
+    template <class F>
+    void pulse_entry_(F&& body); // →.cpp
+    void apply_commands_(std::vector<Command>& buffer); // →.cpp
+    void destroy_detached_(std::unique_ptr<NeneNode> node, std::vector<Command>& buffer, std::size_t from); // →.cpp
+    std::unique_ptr<NeneNode> detach_child_(const std::string& name); // →.cpp
+    void pulse_children_parallel_(const float& dt); // →.cpp
+    void defer_render_dirty_(); // →.cpp
+    std::vector<Command> pulse_commands_;                    // パルスの入口になったときの積み先（使い回し）
+    bool children_independent_ = false;
+    bool parked_ = false;
+    double time_skipped_ = 0.0; // このノードの水門で止めた time_lapse の合計（祖先で止まった分は含まない）
+    std::vector<NeneNode*> parallel_children_;                // 使い回し
+    std::vector<std::vector<Command>> parallel_commands_;     // 子ごとの積み先（使い回し）
     void dump_tree_impl(std::ostream& os, const std::string& prefix, bool is_last) const;
     mutable bool render_cache_dirty_ = true;
     mutable std::vector<NeneNode*> render_cache_;
     void rebuild_render_cache_() const;
+    void render_view_(SDL_Renderer*, SDL_FRect view);
 };
 
 // ねねルート
@@ -97,7 +192,26 @@ public:
     explicit NeneRoot(std::string, const char*, int, int, Uint32, int, int, const char*); // →.cpp
     ~NeneRoot();
     int run(); // →.cpp
+    // 乱数の種（random サービスと黒板の "random_seed" に入る. 既定は起動ごとに違う値）
+    void set_seed(std::uint32_t seed) { seed_ = seed; }
+    std::uint32_t seed() const { return seed_; }
+    // 固定の dt で回す（0 なら実時間）
+    void set_fixed_dt(float dt) { fixed_dt_ = dt; }
+    // 入力を記録する（固定 dt にする. run の前に呼ぶ）
+    void record_to(const std::string& path, float fixed_dt = 1.0f / 60.0f); // →.cpp
+    // 記録を再生する（種と dt は記録から. 描画と待ちを飛ばして全速で回し, 記録が尽きたら終わる）
+    void replay_from(const std::string& path); // →.cpp
+protected:
+    // false にすると SDL イベントを木に流さない（ルートの handle_sdl_event と NeneInput にだけ渡す）
+    // 入力を handle_input で受けるノードだけなら, イベントごとに木を歩かなくて済む
+    void set_sdl_event_walk(bool v) { sdl_event_walk_ = v; }
 private:
+    bool sdl_event_walk_ = true;
+    std::uint32_t seed_ = 0;
+    float fixed_dt_ = 0.0f;
+    std::string record_path_;
+    std::unique_ptr<NeneInputRecorder> recorder_;
+    std::unique_ptr<NeneInputReplay> replay_;
     SDL_Window* window = nullptr;
     SDL_Renderer* renderer = nullptr;
     bool running = false;
@@ -116,21 +230,78 @@ public:
         if (!factory) nnthrow("register_node: factory is null");
         factories_.emplace(std::move(node_name), std::move(factory));
     }
+    // ノードが使うアセット（preload で切替前に温められる）
+    void register_manifest(std::string node_name, NeneAssetManifest manifest) {
+        manifests_[std::move(node_name)] = std::move(manifest);
+    }
+    // 切替先のアセットを裏で読み込んでおく（完了すると自分宛に "preload_done" が届く）
+    void preload(std::string_view node_name) {
+        auto it = manifests_.find(std::string(node_name));
+        if (it == manifests_.end() || !asset_loader) return;
+        if (asset_loader->is_loaded(it->second)) return;
+        asset_loader->preload(it->second, this->name, it->first);
+    }
+    // 切り替えで離れても破棄せず, 水門を閉じて残しておく（戻ってくると続きから）
+    void set_retained(std::string node_name, bool retain = true) {
+        if (retain) retained_.insert(std::move(node_name));
+        else retained_.erase(node_name);
+    }
+    // 切替先を先に組み立てておく（水門を閉じたまま子にする. 切替時は開けるだけ）
+    void prebuild(std::string_view node_name) {
+        const std::string key(node_name);
+        if (is_built(key)) return;
+        build_(key);
+    }
+    // アセットを先読みして, 読み終わったら prebuild する（読むものが無ければすぐ）
+    void prepare(std::string_view node_name) {
+        const std::string key(node_name);
+        auto it = manifests_.find(key);
+        if (it == manifests_.end() || !asset_loader || asset_loader->is_loaded(it->second)) {
+            prebuild(key);
+            return;
+        }
+        prepare_on_preload_.insert(key);
+        asset_loader->preload(it->second, this->name, key);
+    }
+    bool is_built(std::string_view node_name) const {
+        const std::string key(node_name);
+        return scenes_.find(key) != scenes_.end() || building_.find(key) != building_.end();
+    }
     // 現在のノード名（無ければ空）
     const std::string& current_node() const { return current_node_; }
-    // 切替（破棄→生成→build）
+    // 切替（保持/組み立て済みなら水門の開け閉めだけ. 同じノードへの切替はリセットできればその場で）
     void switch_to(std::string_view node_name, bool force = false, bool initial = false) {
         const std::string key(node_name);
         if (!force && current_node_ == key) return;
-        auto it = factories_.find(key);
-        if (it == factories_.end()) nnthrow("switch_to: unknown target: " + key);
-        // 今のノード破棄
-        clear_children();
-        // 新しいノード生成
-        auto node = (it->second)();
-        if (!node) nnthrow("switch_to: factory returned null: " + key);
-        add_child(std::move(node));
-        current_node_ = node_name;
+        if (factories_.find(key) == factories_.end()) nnthrow("switch_to: unknown target: " + key);
+        // やり直し: 対応していればその場でリセット
+        if (force && current_node_ == key && reset_child(key)) {
+            if (!initial) nnlog(std::string("reset ") + current_node_);
+            return;
+        }
+        const std::string prev = current_node_;
+        current_node_ = key;
+        // 今のノードを片付ける（保持するなら水門を閉じるだけ. まだ子になっていなければ反映時に閉じる）
+        if (!prev.empty()) {
+            if (prev != key && retained_.count(prev)) {
+                if (auto cur = scenes_.find(prev); cur != scenes_.end()) {
+                    cur->second->set_active(false);
+                    cur->second->set_parked(true);
+                }
+            } else if (building_.erase(prev) > 0) {
+                remove_child(prev); // 積まれている AddChild の後で外れる
+            } else if (auto cur = scenes_.find(prev); cur != scenes_.end()) {
+                if (!remove_child(prev)) nnthrow("switch_to: scene is not a child: " + prev);
+                scenes_.erase(cur);
+            }
+        }
+        // 組み立て済みなら開けるだけ（まだ子になっていなければ反映時に開く）. 無ければ生成
+        if (auto built = scenes_.find(key); built != scenes_.end()) {
+            built->second->set_active(true);
+            built->second->set_parked(false);
+        } else if (building_.find(key) == building_.end()) {
+            build_(key);
+        }
         if(!force && !initial) { // 最初のツリー生成とリフレッシュはツリーの表示はしない
             nnlog(std::string("switched to ") + current_node_);
             send_mail(NeneMail(this->blackboard->root_name, this->name, "show_all", ""));
@@ -144,15 +315,59 @@ public:
         switch_to(node_name, true, true);
     }
 protected:
+    // 組み立てたシーンは実際に子になったとき（パルス中なら反映時）に scenes_ へ移す
+    // 水門はそのときの current_node_ に合わせて init_node の前に決める
+    void add_child(std::unique_ptr<NeneNode> child) override {
+        if (!child) return;
+        NeneNode* raw = child.get();
+        const std::string key = raw->name;
+        auto b = building_.find(key);
+        const bool scene = b != building_.end() && b->second == raw; // 比べるだけ（積み先で破棄されていてもよい）
+        if (scene) {
+            const bool current = key == current_node_;
+            raw->set_active(current);
+            raw->set_parked(!current);
+        }
+        try {
+            NeneNode::add_child(std::move(child));
+        } catch (...) {
+            if (scene) building_.erase(key);
+            throw;
+        }
+        if (!scene) return;
+        auto it = children.find(key);
+        if (it == children.end() || it->second.get() != raw) return; // まだ積まれただけ
+        building_.erase(key);
+        scenes_[key] = raw;
+    }
     void handle_nene_mail(const NeneMail& mail) override {
         if (mail.to != this->name) return;
+        // prepare の先読みが終わった
+        if (mail.subject == "preload_done") {
+            if (prepare_on_preload_.erase(mail.body) > 0) prebuild(mail.body);
+            return;
+        }
         if (mail.subject != "switch_to") return;
         if (mail.body.empty()) return;
         const bool force = (mail.body == current_node());
         switch_to(mail.body, force);
     }
 private:
+    void build_(const std::string& key) {
+        auto it = factories_.find(key);
+        if (it == factories_.end()) nnthrow("switch_to: unknown target: " + key);
+        auto node = (it->second)();
+        if (!node) nnthrow("switch_to: factory returned null: " + key);
+        if (node->name != key) nnthrow("switch_to: factory must return a node named " + key);
+        building_[key] = node.get();
+        add_child(std::move(node));
+    }
     std::unordered_map<std::string, Factory> factories_;
+    std::unordered_map<std::string, NeneAssetManifest> manifests_;
+    std::unordered_map<std::string, NeneNode*> scenes_; // 子にいるノード（現在 + 保持 + 組み立て済み）
+    std::unordered_map<std::string, const NeneNode*> building_; // AddChild が積まれていてまだ子になっていないもの（比べるだけ）
+    std::unordered_set<std::string> retained_;
+    std::unordered_set<std::string> prepare_on_preload_;
     std::string current_node_;
     std::string mail_subject_ = "switch_to";
 };
@@ -173,3 +388,159 @@ private:
     std::unordered_map<std::string, Factory> factories_;
     std::unordered_map<std::string, int> seq_; // 自動命名用
 };
+
+// ねねタイルマップ (大きな静的背景. タイルをチャンクごとにテクスチャへ焼いて描く)
+class NeneTilemap : public NeneNode {
+public:
+    using Tile = std::uint16_t; // 0 は空タイル
+    static constexpr int kChunkTiles = 16; // 1チャンク = 16x16 タイル
+    NeneTilemap(std::string name, int tile_w, int tile_h, int cols, int rows); // →.cpp
+    ~NeneTilemap() override; // →.cpp
+    // タイルセット（画像の左上から tile_w x tile_h で敷き詰め. タイル番号 t は (t-1) 番目）
+    void set_tileset(SDL_Texture* tex); // →.cpp
+    // マップ左上のワールド座標
+    void set_origin(SDL_FPoint p);      // →.cpp
+    // タイル編集（変わったチャンクだけ焼き直す）
+    void set_tile(int col, int row, Tile t); // →.cpp
+    Tile tile(int col, int row) const;       // →.cpp
+    void fill(Tile t);                       // →.cpp
+    int cols() const { return cols_; }
+    int rows() const { return rows_; }
+    // 当たり判定を持つタイル番号
+    void set_solid(Tile t, bool v); // →.cpp
+    // 固体タイルを長方形にまとめた静的コライダーを CollisionWorld に自動生成する
+    void enable_colliders(std::uint32_t layer, std::uint32_t mask, NenePolygonColor color); // →.cpp
+protected:
+    void handle_time_lapse(const float&) override;   // →.cpp
+    void render(SDL_Renderer*) override;             // →.cpp
+    bool render_bounds(SDL_FRect& out) const override; // →.cpp
+private:
+    struct Chunk {
+        SDL_Texture* tex = nullptr;
+        bool dirty = true;
+    };
+    void bake_chunk_(SDL_Renderer* r, int cx, int cy, Chunk& chunk); // →.cpp
+    void rebuild_colliders_(); // →.cpp
+    void release_colliders_(); // →.cpp
+    bool is_solid_(Tile t) const { return t < solid_.size() && solid_[t]; }
+    int tile_w_ = 0;
+    int tile_h_ = 0;
+    int cols_ = 0;
+    int rows_ = 0;
+    int chunk_cols_ = 0;
+    int chunk_rows_ = 0;
+    SDL_FPoint origin_{ 0.0f, 0.0f };
+    SDL_Texture* tileset_ = nullptr;
+    int tileset_cols_ = 0;
+    std::vector<Tile> tiles_;
+    std::vector<Chunk> chunks_;
+    // コライダー
+    std::vector<bool> solid_;
+    bool colliders_enabled_ = false;
+    bool colliders_dirty_ = false;
+    std::uint32_t collider_layer_ = 1;
+    std::uint32_t collider_mask_ = 0xFFFFFFFFu;
+    NenePolygonColor collider_color_ = NenePolygonColor::None;
+    std::vector<NeneCollisionWorld::ColliderId> collider_ids_;
+};
+
+// ねねパーティクル (粒をまとめて持つノード. 粒ごとにノードを作らない)
+// 粒は SoA の配列に持ち, 寿命が尽きた粒は末尾と入れ替えて詰める. 描画は SDL_RenderGeometry 1回
+class NeneParticleEmitter : public NeneNode {
+public:
+    struct Params {
+        SDL_FPoint position{ 0.0f, 0.0f }; // 発生位置（ワールド座標）
+        SDL_FPoint spread{ 0.0f, 0.0f };   // 発生位置のばらつき（±）
+        float rate = 0.0f;                 // 毎秒の発生数（0 なら emit したときだけ出る）
+        float life_min = 0.5f;             // 寿命（秒）
+        float life_max = 1.0f;
+        float speed_min = 0.0f;
+        float speed_max = 100.0f;
+        float angle_min = 0.0f;            // 向き（ラジアン. 0 が右で, y が下向きなので時計回り）
+        float angle_max = 6.2831853f;
+        SDL_FPoint gravity{ 0.0f, 0.0f };
+        float size_start = 4.0f;           // 一辺の長さ（寿命に沿って線形に変わる）
+        float size_end = 4.0f;
+        SDL_FColor color_start{ 1.0f, 1.0f, 1.0f, 1.0f };
+        SDL_FColor color_end{ 1.0f, 1.0f, 1.0f, 0.0f };
+    };
+    // capacity 個分の配列を最初に確保する（それ以上は出ない）
+    NeneParticleEmitter(std::string name, std::size_t capacity); // →.cpp
+    Params& params() { return params_; }
+    const Params& params() const { return params_; }
+    void set_params(const Params& p) { params_ = p; }
+    void set_position(SDL_FPoint p) { params_.position = p; }
+    // テクスチャ（nullptr なら単色の四角. src が nullptr ならテクスチャ全体）
+    void set_texture(SDL_Texture* tex, const SDL_FRect* src = nullptr); // →.cpp
+    // rate による自動発生の ON/OFF
+    void set_emitting(bool v) { emitting_ = v; }
+    bool emitting() const { return emitting_; }
+    // 今すぐ n 個出す. 入りきらない分は捨てて, 出した数を返す
+    std::size_t emit(std::size_t n); // →.cpp
+    void clear() { size_ = 0; spawn_acc_ = 0.0f; }
+    std::size_t size() const { return size_; }
+    std::size_t capacity() const { return capacity_; }
+protected:
+    void handle_time_lapse(const float& dt) override; // →.cpp
+    void render(SDL_Renderer* r) override;            // →.cpp
+    bool reset_node() override { clear(); return true; }
+private:
+    void integrate_(float dt); // →.cpp
+    void compact_();           // →.cpp
+    NeneRng& rng_();           // →.cpp
+    Params params_;
+    std::size_t capacity_ = 0;
+    std::size_t size_ = 0;
+    // 粒（SoA. t_ は寿命に対する経過 0→1, inv_life_ は 1/寿命）
+    std::vector<float> x_, y_, vx_, vy_, t_, inv_life_;
+    float spawn_acc_ = 0.0f;
+    bool emitting_ = true;
+    // 乱数は初めて使うときにルートの種から自分用のストリームを作る
+    NeneRng rng_state_;
+    bool rng_ready_ = false;
+    // 描画
+    SDL_Texture* texture_ = nullptr;
+    SDL_FRect uv_{ 0.0f, 0.0f, 1.0f, 1.0f };
+    std::vector<SDL_Vertex> verts_;
+    std::vector<int> indices_; // 容量分を最初に作っておく（中身は粒の数に依らない）
+};
+
+// ねねエンティティホスト (大量の単純な物体を NeneRegistry に持つノード. 物体ごとにノードを作らない)
+// 物体のデータは型ごとの詰めた配列に入り, 登録したシステムが time_lapse のたびに登録順にそれを回す
+// シーンや UI はこれまで通りノードで作り, 数の多いものだけここに入れる
+class NeneEntityHost : public NeneNode {
+public:
+    using System = std::function<void(NeneRegistry&, float)>;
+    using RenderSystem = std::function<void(NeneRegistry&, SDL_Renderer*, const NeneCamera*)>;
+    explicit NeneEntityHost(std::string name) : NeneNode(std::move(name)) {}
+    NeneRegistry& registry() { return registry_; }
+    const NeneRegistry& registry() const { return registry_; }
+    // 同じ名前で登録すると置き換える
+    // システムの中から呼んでもよい（動いているシステムは壊さず, 回し終わってから反映する）
+    void add_system(std::string name, System fn);              // →.cpp
+    void add_render_system(std::string name, RenderSystem fn); // →.cpp
+    bool remove_system(std::string_view name);                 // →.cpp
+protected:
+    void handle_time_lapse(const float& dt) override; // →.cpp
+    void render(SDL_Renderer* r) override;            // →.cpp
+private:
+    template <class Fn>
+    struct Entry {
+        std::string name;
+        Fn fn;
+    };
+    // 登録の変更（fn も render_fn も空なら削除）
+    struct Change {
+        std::string name;
+        System fn;
+        RenderSystem render_fn;
+    };
+    void request_(Change c); // →.cpp
+    void apply_(Change c);   // →.cpp
+    void apply_pending_();   // →.cpp
+    NeneRegistry registry_;
+    std::vector<Entry<System>> systems_;
+    std::vector<Entry<RenderSystem>> render_systems_;
+    bool running_ = false; // システムを回している最中
+    std::vector<Change> pending_;
+};
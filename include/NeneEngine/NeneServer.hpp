@@ -1,5 +1,9 @@
 #pragma once
+#include <array>
 #include <deque>
+#include <exception>
+#include <fstream>
+#include <list>
 #include <memory>
 #include <optional>
 #include <string_view>
@@ -11,9 +15,24 @@
 #include <cstdint>
 #include <limits>
 #include <functional>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <SDL3/SDL.h>
 #include <SDL3_image/SDL_image.h>
 #include <SDL3_ttf/SDL_ttf.h>
+#include <NeneEngine/NeneComponents.hpp>
+
+// 並列パルスの見張り
+// NeneWorkerPool::parallel_for のタスクを実行している間だけ true（そのスレッドだけ）
+bool nene_in_parallel_task(); // →.cpp
+// 共有サービスを書き換える入口で呼ぶ（登録・読み込みなど. ワーカーから呼ばれたら throw）
+inline void nene_require_serial(const char* what) {
+    if (nene_in_parallel_task()) throw std::runtime_error(std::string(what) + ": not allowed during a parallel pulse");
+}
 
 // NeneColorPolygon
 // 凸多角形ヒットボックス
@@ -71,19 +90,20 @@ public:
             out.push_back(SDL_FPoint{ v.x + position.x, v.y + position.y });
         }
     }
-    void debug_render_filled(SDL_Renderer* r) const {
+    // origin/zoom はカメラの変換（スクリーン = (ワールド - origin) * zoom）
+    void debug_render_filled(SDL_Renderer* r, SDL_FPoint origin = SDL_FPoint{ 0.0f, 0.0f }, float zoom = 1.0f) const {
         if (!r) return;
         if (!enabled) return;
         if (!debug_draw) return;
         const std::size_t n = vertices.size();
         if (n < 3) return;
-        // ワールド座標へ
+        // スクリーン座標へ
         std::vector<SDL_Vertex> vtx;
         vtx.resize(n);
         const SDL_FColor col = nene_to_fcolor(color, debug_alpha);
         for (std::size_t i = 0; i < n; ++i) {
-            const float wx = vertices[i].x + position.x;
-            const float wy = vertices[i].y + position.y;
+            const float wx = (vertices[i].x + position.x - origin.x) * zoom;
+            const float wy = (vertices[i].y + position.y - origin.y) * zoom;
             vtx[i].position = SDL_FPoint{ wx, wy };
             vtx[i].color    = col;
             vtx[i].tex_coord = SDL_FPoint{ 0.0f, 0.0f }; // texture=nullptr なので未使用
@@ -112,11 +132,13 @@ public:
     using HitRef     = std::reference_wrapper<NeneColorPolygon>;
     using ConstHitRef= std::reference_wrapper<const NeneColorPolygon>;
     ColliderId add_collider(NeneColorPolygon collider) {
+        nene_require_serial("NeneCollisionWorld::add_collider");
         collider.id = next_id_++;
         colliders_.push_back(std::move(collider));
         return colliders_.back().id;
     }
     bool remove_collider(ColliderId id) {
+        nene_require_serial("NeneCollisionWorld::remove_collider");
         for (std::size_t i = 0; i < colliders_.size(); ++i) {
             if (colliders_[i].id == id) {
                 colliders_.erase(colliders_.begin() + static_cast<std::ptrdiff_t>(i));
@@ -126,6 +148,7 @@ public:
         return false;
     }
     void clear() {
+        nene_require_serial("NeneCollisionWorld::clear");
         colliders_.clear();
         next_id_ = 1;
     }
@@ -137,13 +160,16 @@ public:
         for (const auto& c : colliders_) if (c.id == id) return &c;
         return nullptr;
     }
+    // 並列パルスの中からはノードの set_collider_position を使う
     bool set_position(ColliderId id, SDL_FPoint pos) {
+        nene_require_serial("NeneCollisionWorld::set_position");
         auto* c = find(id);
         if (!c) return false;
         c->position = pos;
         return true;
     }
     bool set_enabled(ColliderId id, bool v) {
+        nene_require_serial("NeneCollisionWorld::set_enabled");
         auto* c = find(id);
         if (!c) return false;
         c->enabled = v;
@@ -153,23 +179,24 @@ public:
     // 当たらなければ std::nullopt
     std::optional<HitRef> detect_collision(NeneColorPolygon& target) {
         if (!target.enabled) return std::nullopt;
+        Scratch& tmp = scratch_();
         // ターゲットのワールド頂点を準備
-        target.compute_world_vertices(tmpA_);
+        target.compute_world_vertices(tmp.a);
         // 頂点が少なすぎるものは無視
-        if (tmpA_.size() < 3) return std::nullopt;
+        if (tmp.a.size() < 3) return std::nullopt;
         // 早期：ターゲットAABB（任意だけど軽くなる）
-        const SDL_FRect aabbA = compute_aabb_(tmpA_);
+        const SDL_FRect aabbA = compute_aabb_(tmp.a);
         for (auto& other : colliders_) {
             if (!other.enabled) continue;
             if (other.id == target.id && target.id != 0) continue;
             // layer/mask フィルタ（不要なら削ってOK）
             if ((target.mask & other.layer) == 0) continue;
             if ((other.mask  & target.layer) == 0) continue;
-            other.compute_world_vertices(tmpB_);
-            if (tmpB_.size() < 3) continue;
-            const SDL_FRect aabbB = compute_aabb_(tmpB_);
+            other.compute_world_vertices(tmp.b);
+            if (tmp.b.size() < 3) continue;
+            const SDL_FRect aabbB = compute_aabb_(tmp.b);
             if (!aabb_intersects_(aabbA, aabbB)) continue;
-            if (sat_intersects_convex_(tmpA_, tmpB_)) {
+            if (sat_intersects_convex_(tmp.a, tmp.b)) {
                 return HitRef{other};
             }
         }
@@ -177,19 +204,20 @@ public:
     }
     std::optional<ConstHitRef> detect_collision(const NeneColorPolygon& target) const {
         if (!target.enabled) return std::nullopt;
-        target.compute_world_vertices(tmpA_const_);
-        if (tmpA_const_.size() < 3) return std::nullopt;
-        const SDL_FRect aabbA = compute_aabb_(tmpA_const_);
+        Scratch& tmp = scratch_();
+        target.compute_world_vertices(tmp.a);
+        if (tmp.a.size() < 3) return std::nullopt;
+        const SDL_FRect aabbA = compute_aabb_(tmp.a);
         for (const auto& other : colliders_) {
             if (!other.enabled) continue;
             if (other.id == target.id && target.id != 0) continue;
             if ((target.mask & other.layer) == 0) continue;
             if ((other.mask  & target.layer) == 0) continue;
-            other.compute_world_vertices(tmpB_const_);
-            if (tmpB_const_.size() < 3) continue;
-            const SDL_FRect aabbB = compute_aabb_(tmpB_const_);
+            other.compute_world_vertices(tmp.b);
+            if (tmp.b.size() < 3) continue;
+            const SDL_FRect aabbB = compute_aabb_(tmp.b);
             if (!aabb_intersects_(aabbA, aabbB)) continue;
-            if (sat_intersects_convex_(tmpA_const_, tmpB_const_)) {
+            if (sat_intersects_convex_(tmp.a, tmp.b)) {
                 return ConstHitRef{other};
             }
         }
@@ -272,12 +300,16 @@ private:
 private:
     std::vector<NeneColorPolygon> colliders_;
     ColliderId next_id_ = 1;
-    // 一時バッファ（毎回確保しない）
-    std::vector<SDL_FPoint> tmpA_;
-    std::vector<SDL_FPoint> tmpB_;
-    // const版用（mutable にしても良いけど、ここでは分ける）
-    mutable std::vector<SDL_FPoint> tmpA_const_;
-    mutable std::vector<SDL_FPoint> tmpB_const_;
+    // 一時バッファ（毎回確保しない. 並列パルスの中から判定するときはスレッドごとのものを使う）
+    struct Scratch {
+        std::vector<SDL_FPoint> a;
+        std::vector<SDL_FPoint> b;
+    };
+    Scratch& scratch_() const {
+        thread_local Scratch local;
+        return nene_in_parallel_task() ? local : scratch_main_;
+    }
+    mutable Scratch scratch_main_;
 };
 
 enum class PlayMode : std::uint8_t {
@@ -285,6 +317,53 @@ enum class PlayMode : std::uint8_t {
     Release
 };
 
+// 型付きスロットのハンドル（NeneBlackboard::key で作る）
+template <class T>
+struct NeneBBKey {
+    static constexpr std::uint32_t invalid = std::numeric_limits<std::uint32_t>::max();
+    std::uint32_t index = invalid;
+    bool valid() const { return index != invalid; }
+};
+
+class NeneBlackboard;
+class NeneMailServer;
+
+// 購読の持ち主トークン（破棄すると購読も外れる. 黒板が先に消えても安全）
+class NeneBBSubscription {
+public:
+    NeneBBSubscription() = default;
+    ~NeneBBSubscription() { reset(); }
+    NeneBBSubscription(NeneBBSubscription&& o) noexcept
+        : bb_(o.bb_), life_(std::move(o.life_)), kind_(o.kind_), index_(o.index_), id_(o.id_) {
+        o.bb_ = nullptr;
+    }
+    NeneBBSubscription& operator=(NeneBBSubscription&& o) noexcept {
+        if (this == &o) return *this;
+        reset();
+        bb_ = o.bb_;
+        life_ = std::move(o.life_);
+        kind_ = o.kind_;
+        index_ = o.index_;
+        id_ = o.id_;
+        o.bb_ = nullptr;
+        return *this;
+    }
+    NeneBBSubscription(const NeneBBSubscription&) = delete;
+    NeneBBSubscription& operator=(const NeneBBSubscription&) = delete;
+    void reset(); // →NeneBlackboard の後ろ
+    explicit operator bool() const { return bb_ != nullptr; }
+private:
+    friend class NeneBlackboard;
+    NeneBBSubscription(NeneBlackboard* bb, std::weak_ptr<char> life,
+                       std::uint8_t kind, std::uint32_t index, std::uint64_t id)
+        : bb_(bb), life_(std::move(life)), kind_(kind), index_(index), id_(id) {}
+    NeneBlackboard* bb_ = nullptr;
+    std::weak_ptr<char> life_;
+    std::uint8_t kind_ = 0;
+    std::uint32_t index_ = 0;
+    std::uint64_t id_ = 0;
+};
+
 // ノード間データ共有サービス
 class NeneBlackboard {
 public:
@@ -304,25 +383,305 @@ public:
     float ground_y = window_h - 120.0f;   // 地面の高さ（ピクセル）
     float gravity  = 2400.0f;             // 重力（px/s^2）
     float scroll_speed = 420.0f;          // 横スクロール速度（px/s）
-    // --- ユーザー拡張（float）---
-    std::unordered_map<std::string, float> user_floats;
-    // API
-    void setf(const std::string& key, float v) { user_floats[key] = v; }
+    // --- ユーザー拡張（型付きスロット）---
+    // 名前の登録は init_node で1回だけ. 以降はハンドルで直接読み書きする（文字列のハッシュを取らない）
+    template <class T>
+    NeneBBKey<T> key(const std::string& name, const T& default_value = T{}) {
+        auto& s = slots_<T>();
+        auto it = s.index.find(name);
+        if (it != s.index.end()) return NeneBBKey<T>{ it->second };
+        nene_require_serial("NeneBlackboard::key");
+        auto [kit, inserted] = kinds_.emplace(name, kind_v<T>);
+        if (!inserted) {
+            throw std::runtime_error("NeneBlackboard: key '" + name + "' is registered with another type");
+        }
+        const std::uint32_t idx = static_cast<std::uint32_t>(s.values.size());
+        s.values.push_back(default_value);
+        s.versions.push_back(0);
+        s.names.push_back(name);
+        s.subs.emplace_back();
+        s.dirty.push_back(0);
+        s.index.emplace(name, idx);
+        return NeneBBKey<T>{ idx };
+    }
+    // 登録済みなら返す（無ければ invalid なハンドル）
+    template <class T>
+    NeneBBKey<T> find(const std::string& name) const {
+        const auto& s = slots_<T>();
+        auto it = s.index.find(name);
+        return (it == s.index.end()) ? NeneBBKey<T>{} : NeneBBKey<T>{ it->second };
+    }
+    template <class T>
+    const T& get(NeneBBKey<T> k) const { return slots_<T>().values[k.index]; }
+    // 値が変わったときだけ版数を進める
+    template <class T>
+    void set(NeneBBKey<T> k, const T& v) {
+        if (double_buffered_) {
+            stage_<T>().push_back(Staged<T>{ k.index, writer_rank(), false, v });
+            return;
+        }
+        nene_require_serial("NeneBlackboard::set (turn on double buffering)");
+        auto& s = slots_<T>();
+        if (same_(s.values[k.index], v)) return;
+        s.values[k.index] = v;
+        ++s.versions[k.index];
+        mark_dirty_(s, k.index);
+    }
+    // 加算（float/int）
+    template <class T>
+    void add(NeneBBKey<T> k, const T& delta) {
+        static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "add needs float or int");
+        if (delta == T{}) return;
+        if (double_buffered_) {
+            stage_<T>().push_back(Staged<T>{ k.index, writer_rank(), true, delta });
+            return;
+        }
+        nene_require_serial("NeneBlackboard::add (turn on double buffering)");
+        auto& s = slots_<T>();
+        s.values[k.index] += delta;
+        ++s.versions[k.index];
+        mark_dirty_(s, k.index);
+    }
+    // 書き込みのたびに進む版数（前回見た値と比べれば変化の有無が分かる）
+    template <class T>
+    std::uint32_t version(NeneBBKey<T> k) const { return slots_<T>().versions[k.index]; }
+    template <class T>
+    const std::string& name_of(NeneBBKey<T> k) const { return slots_<T>().names[k.index]; }
+
+    // --- 購読（ポーリングの代わり）---
+    // 登録した時点の値ですぐ1回呼ぶ. 以降は値が変わったフレームの flush で1回だけ呼ぶ（何回書いてもまとめる）
+    template <class T>
+    [[nodiscard]] NeneBBSubscription subscribe(NeneBBKey<T> k, std::function<void(const T&)> fn) {
+        nene_require_serial("NeneBlackboard::subscribe");
+        auto& s = slots_<T>();
+        const std::uint64_t id = next_sub_id_++;
+        s.subs[k.index].push_back(Sub<T>{ id, std::move(fn), {}, {} });
+        s.subs[k.index].back().fn(s.values[k.index]);
+        return NeneBBSubscription(this, life_, kind_v<T>, k.index, id);
+    }
+    // メールで知らせる（本文はキー名）
+    template <class T>
+    [[nodiscard]] NeneBBSubscription subscribe_mail(NeneBBKey<T> k, std::string to, std::string subject) {
+        nene_require_serial("NeneBlackboard::subscribe_mail");
+        auto& s = slots_<T>();
+        const std::uint64_t id = next_sub_id_++;
+        s.subs[k.index].push_back(Sub<T>{ id, nullptr, std::move(to), std::move(subject) });
+        return NeneBBSubscription(this, life_, kind_v<T>, k.index, id);
+    }
+    // 変わった値の購読者を呼ぶ（ルートが毎フレーム1回呼ぶ. 購読者の中で書いた値は次の flush で知らせる）
+    void flush(NeneMailServer& mail); // →.cpp
+
+    // --- ダブルバッファ（並列更新用）---
+    // ON の間, get はフレーム頭の確定値を返し, set/add はスレッドごとの下書きに積む
+    // commit（ルートがフレーム末に呼ぶ）で下書きをまとめて確定する. 規則はスレッド数に依らない:
+    //   set: writer_rank が一番大きいものが勝つ（同じなら値の大きい方）
+    //   add: 確定値（set があればその値）に, 値の小さい順に足す
+    // キーの登録（key）と購読はスレッドを走らせる前（init_node）に済ませておくこと（並列パルス中は throw）
+    // OFF のまま並列パルスの中から set/add すると throw する
+    void set_double_buffered(bool on); // →.cpp
+    bool double_buffered() const { return double_buffered_; }
+    void commit(); // →.cpp
+    // このスレッドの書き込み順位（エンジンが並列実行するときに木の順番を入れる）
+    static void set_writer_rank(std::uint32_t rank); // →.cpp
+    static std::uint32_t writer_rank(); // →.cpp
+
+    // --- 文字列 API（float. 毎フレーム呼ぶ場所ではハンドルを使う）---
+    void setf(const std::string& key, float v) { set(this->key<float>(key, v), v); }
     // 無い値をgetしようとするとデフォルトが返る
     float getf(const std::string& key, float default_value = 0.0f) const {
-        auto it = user_floats.find(key);
-        return (it == user_floats.end()) ? default_value : it->second;
+        const auto k = find<float>(key);
+        return k.valid() ? get(k) : default_value;
     }
     bool hasf(const std::string& key) const {
-        return user_floats.find(key) != user_floats.end();
+        return find<float>(key).valid();
     }
     // 無ければ作って返す（初期値 default_value）
+    // 参照越しの書き込みは追えないので、呼んだ時点で書き込みとみなして版数を進める
     float& ensuref(const std::string& key, float default_value = 0.0f) {
-        auto [it, inserted] = user_floats.emplace(key, default_value);
-        return it->second;
+        if (double_buffered_) {
+            throw std::runtime_error("NeneBlackboard: ensuref is not available in double-buffered mode (use add)");
+        }
+        nene_require_serial("NeneBlackboard::ensuref");
+        const auto k = this->key<float>(key, default_value);
+        auto& s = slots_<float>();
+        ++s.versions[k.index];
+        mark_dirty_(s, k.index);
+        return s.values[k.index];
     }
+private:
+    friend class NeneBBSubscription;
+    template <class T>
+    struct Sub {
+        std::uint64_t id;
+        std::function<void(const T&)> fn; // 空ならメールで知らせる
+        std::string mail_to;
+        std::string mail_subject;
+    };
+    template <class T>
+    struct Slots {
+        std::deque<T> values; // deque なので登録が増えても参照が動かない
+        std::vector<std::uint32_t> versions;
+        std::vector<std::string> names;
+        std::unordered_map<std::string, std::uint32_t> index;
+        // 購読
+        std::vector<std::vector<Sub<T>>> subs;
+        std::vector<std::uint8_t> dirty;
+        std::vector<std::uint32_t> dirty_list;
+        std::vector<std::uint32_t> flushing; // flush 中に使う（使い回し）
+    };
+    // 購読者がいるスロットだけ記録する
+    template <class T>
+    static void mark_dirty_(Slots<T>& s, std::uint32_t idx) {
+        if (s.subs[idx].empty() || s.dirty[idx]) return;
+        s.dirty[idx] = 1;
+        s.dirty_list.push_back(idx);
+    }
+    template <class T>
+    void flush_slots_(Slots<T>& s, NeneMailServer& mail); // →.cpp
+    // ダブルバッファの下書き
+    template <class T>
+    struct Staged {
+        std::uint32_t index;
+        std::uint32_t rank;
+        bool add;
+        T value;
+    };
+    template <class T>
+    using StagedList = std::vector<Staged<T>>;
+    struct Stage {
+        std::tuple<StagedList<float>, StagedList<int>, StagedList<bool>,
+                   StagedList<SDL_FPoint>, StagedList<std::string>> ops;
+    };
+    Stage& this_thread_stage_(); // →.cpp
+    template <class T>
+    StagedList<T>& stage_() { return std::get<StagedList<T>>(this_thread_stage_().ops); }
+    template <class T>
+    void commit_slots_(Slots<T>& s, StagedList<T>& merged); // →.cpp
+    template <class T>
+    static bool less_(const T& a, const T& b) { return a < b; }
+    static bool less_(const SDL_FPoint& a, const SDL_FPoint& b) {
+        return (a.x != b.x) ? (a.x < b.x) : (a.y < b.y);
+    }
+    void unsubscribe_(std::uint8_t kind, std::uint32_t index, std::uint64_t id); // →.cpp
+    template <class T>
+    static constexpr std::uint8_t kind_v =
+        std::is_same_v<T, float>       ? 0 :
+        std::is_same_v<T, int>         ? 1 :
+        std::is_same_v<T, bool>        ? 2 :
+        std::is_same_v<T, SDL_FPoint>  ? 3 :
+        std::is_same_v<T, std::string> ? 4 : 255;
+    template <class T>
+    Slots<T>& slots_() {
+        static_assert(kind_v<T> != 255, "NeneBlackboard: unsupported slot type");
+        return std::get<Slots<T>>(slots_data_);
+    }
+    template <class T>
+    const Slots<T>& slots_() const {
+        static_assert(kind_v<T> != 255, "NeneBlackboard: unsupported slot type");
+        return std::get<Slots<T>>(slots_data_);
+    }
+    template <class T>
+    static bool same_(const T& a, const T& b) { return a == b; }
+    static bool same_(const SDL_FPoint& a, const SDL_FPoint& b) { return a.x == b.x && a.y == b.y; }
+    std::tuple<Slots<float>, Slots<int>, Slots<bool>, Slots<SDL_FPoint>, Slots<std::string>> slots_data_;
+    std::unordered_map<std::string, std::uint8_t> kinds_; // 名前→型（型違いの二重登録を防ぐ）
+    std::uint64_t next_sub_id_ = 1;
+    bool flushing_ = false;
+    bool double_buffered_ = false;
+    std::uint64_t serial_ = next_serial_(); // スレッド側のキャッシュが別の黒板を掴まないように
+    static std::uint64_t next_serial_(); // →.cpp
+    std::mutex stage_mutex_;
+    std::unordered_map<std::thread::id, std::unique_ptr<Stage>> stages_;
+    Stage merged_; // commit 用（使い回し）
+    std::shared_ptr<char> life_ = std::make_shared<char>(0); // トークンが黒板の生存を確かめる
 };
 
+inline void NeneBBSubscription::reset() {
+    if (bb_ && !life_.expired()) bb_->unsubscribe_(kind_, index_, id_);
+    bb_ = nullptr;
+    life_.reset();
+}
+
+
+
+// NeneCamera
+// カメラ/ビューポートサービス（ワールド座標→スクリーン座標の変換を一か所で持つ）
+struct NeneViewport {
+    SDL_FRect screen{ 0.0f, 0.0f, 0.0f, 0.0f }; // 画面上の描画領域（w/h が 0 ならウィンドウ全体）
+    SDL_FPoint position{ 0.0f, 0.0f };          // 画面左上に映るワールド座標
+    float zoom = 1.0f;
+    bool enabled = true;
+};
+
+// パララックスレイヤー（render_z の範囲ごとにカメラの効き方を変える）
+struct NeneParallaxLayer {
+    int z_min = 0;
+    int z_max = 0;
+    float scroll = 1.0f;   // カメラ移動量に掛ける係数（0 で画面固定, 0.5 で半分の速さ）
+    bool  zoom = true;     // false ならズームの影響を受けない（HUD など）
+};
+
+class NeneCamera {
+public:
+    NeneCamera() { viewports_.push_back(NeneViewport{}); }
+    // ビューポート（0番がメイン. 画面分割したいときは追加する）
+    NeneViewport& main() { return viewports_.front(); }
+    const NeneViewport& main() const { return viewports_.front(); }
+    std::size_t add_viewport(NeneViewport vp) {
+        viewports_.push_back(vp);
+        return viewports_.size() - 1;
+    }
+    NeneViewport& viewport(std::size_t i) { return viewports_.at(i); }
+    const NeneViewport& viewport(std::size_t i) const { return viewports_.at(i); }
+    std::size_t viewport_count() const { return viewports_.size(); }
+    // パララックスレイヤー（範囲が重なったら先に登録した方を使う）
+    void add_layer(NeneParallaxLayer layer) { layers_.push_back(layer); }
+    void clear_layers() { layers_.clear(); }
+    const NeneParallaxLayer* layer_for(int z) const {
+        for (const auto& l : layers_) {
+            if (z >= l.z_min && z <= l.z_max) return &l;
+        }
+        return nullptr;
+    }
+    // --- 描画中の変換（pulse_render がビューポート/レイヤーごとに設定する）---
+    void begin_view(const NeneViewport& vp, float screen_w, float screen_h) {
+        view_ = vp;
+        view_w_ = (vp.screen.w > 0.0f) ? vp.screen.w : screen_w;
+        view_h_ = (vp.screen.h > 0.0f) ? vp.screen.h : screen_h;
+        set_layer_z(0);
+    }
+    void set_layer_z(int z) {
+        const NeneParallaxLayer* l = layer_for(z);
+        const float scroll = l ? l->scroll : 1.0f;
+        scale_  = (!l || l->zoom) ? view_.zoom : 1.0f;
+        if (scale_ <= 0.0f) scale_ = 1.0f;
+        origin_ = SDL_FPoint{ view_.position.x * scroll, view_.position.y * scroll };
+    }
+    // 変換
+    SDL_FPoint to_screen(SDL_FPoint p) const {
+        return SDL_FPoint{ (p.x - origin_.x) * scale_, (p.y - origin_.y) * scale_ };
+    }
+    SDL_FRect to_screen(const SDL_FRect& r) const {
+        return SDL_FRect{ (r.x - origin_.x) * scale_, (r.y - origin_.y) * scale_, r.w * scale_, r.h * scale_ };
+    }
+    SDL_FPoint to_world(SDL_FPoint p) const {
+        return SDL_FPoint{ p.x / scale_ + origin_.x, p.y / scale_ + origin_.y };
+    }
+    // 今のビューポート/レイヤーで見えているワールド範囲（カリング用）
+    SDL_FRect visible_rect() const {
+        return SDL_FRect{ origin_.x, origin_.y, view_w_ / scale_, view_h_ / scale_ };
+    }
+    SDL_FPoint origin() const { return origin_; }
+    float scale() const { return scale_; }
+private:
+    std::vector<NeneViewport> viewports_;
+    std::vector<NeneParallaxLayer> layers_;
+    NeneViewport view_{};
+    float view_w_ = 0.0f;
+    float view_h_ = 0.0f;
+    SDL_FPoint origin_{ 0.0f, 0.0f };
+    float scale_ = 1.0f;
+};
 
 
 // PathService
@@ -404,60 +763,493 @@ private:
 };
 
 
+// NeneAnimationSystem
+// アニメーション再生サービス
+// 再生中のアニメーションを SoA で持ち, update でまとめて進める. ノードは描画時に src を読むだけ
+// クリップは clips() に登録しておき, id で再生する
+using NeneAnimId = std::uint32_t; // 0 は無効
+struct NeneAnimFinished {
+    NeneAnimId id = 0;
+    NeneAnimClipId clip = kNeneNoClip;
+};
+class NeneAnimationSystem {
+public:
+    NeneAnimClipLibrary& clips() { return clips_; }
+    const NeneAnimClipLibrary& clips() const { return clips_; }
+    // 追加. notify_to を渡すとループしないクリップが終わったときに "anim_finished"（body はクリップ名）が届く
+    // owner を渡すと update の paused(owner) が true の間は進まない（ノードなら this. 消えるときに remove_owner される）
+    // 追加・削除・update は並列パルスの中からは呼べない（throw）. play/set_speed は自分の id なら呼んでよい
+    NeneAnimId add(NeneAnimClipId clip = kNeneNoClip, const std::string& notify_to = "", const void* owner = nullptr); // →.cpp
+    void remove(NeneAnimId id); // →.cpp
+    std::size_t remove_owner(const void* owner); // →.cpp
+    bool contains(NeneAnimId id) const { return dense_of_(id) != kNone; }
+    std::size_t size() const { return ids_.size(); }
+    void play(NeneAnimId id, NeneAnimClipId clip, bool restart=false); // →.cpp
+    void play(NeneAnimId id, std::string_view name, bool restart=false) { play(id, clips_.id(name), restart); }
+    void set_speed(NeneAnimId id, float s) { if (auto i = dense_of_(id); i != kNone) speed_[i] = s; } // 0で停止も可
+    float speed(NeneAnimId id) const { auto i = dense_of_(id); return i != kNone ? speed_[i] : 0.0f; }
+    bool finished(NeneAnimId id) const { auto i = dense_of_(id); return i != kNone && finished_[i] != 0; }
+    NeneAnimClipId current(NeneAnimId id) const { auto i = dense_of_(id); return i != kNone ? clip_[i] : kNeneNoClip; }
+    // 今のフレームの切り出し範囲（再生していなければ nullptr）
+    const SDL_FRect* src(NeneAnimId id) const {
+        const std::uint32_t i = dense_of_(id);
+        if (i == kNone || count_[i] == 0) return nullptr;
+        return &clips_.frame_src(first_[i] + idx_[i]);
+    }
+    // 全体の一時停止
+    void set_paused(bool v) { paused_ = v; }
+    bool paused() const { return paused_; }
+    // 全部まとめて進める（ルートが time_lapse の後に1回呼ぶ. paused は持ち主ごとの一時停止）
+    using OwnerPaused = bool (*)(const void* owner);
+    void update(float dt, NeneMailServer& mail_server, OwnerPaused paused = nullptr); // →.cpp
+    // 直近の update で終わったもの
+    const std::vector<NeneAnimFinished>& finished_events() const { return events_; }
+private:
+    static constexpr std::uint32_t kNone = std::numeric_limits<std::uint32_t>::max();
+    std::uint32_t dense_of_(NeneAnimId id) const {
+        return id < sparse_.size() ? sparse_[id] : kNone;
+    }
+    void start_(std::uint32_t i, NeneAnimClipId clip); // →.cpp
+    void advance_(std::uint32_t i); // →.cpp
+private:
+    NeneAnimClipLibrary clips_;
+    // id -> 添字（0 番は使わない）
+    std::vector<std::uint32_t> sparse_{ kNone };
+    // 以下は添字ごと（削除は末尾と入れ替え）
+    std::vector<NeneAnimId> ids_;
+    std::vector<NeneAnimClipId> clip_;
+    std::vector<std::uint32_t> first_;
+    std::vector<std::uint32_t> count_;
+    std::vector<std::uint32_t> idx_;
+    std::vector<float> t_;
+    std::vector<float> dur_;   // 今のフレームの長さ（止まっているものは無限大）
+    std::vector<float> speed_;
+    std::vector<std::uint8_t> finished_;
+    std::vector<std::string> notify_;
+    std::vector<const void*> owner_;
+    // 持ち主ごとの数（持ち主のいないノードの remove_owner はこれを引くだけ）
+    std::unordered_map<const void*, std::uint32_t> owned_;
+    // update 用
+    std::vector<std::uint32_t> due_;
+    std::vector<float> gate_; // 持ち主が止まっていれば 0
+    std::vector<NeneAnimFinished> events_;
+    bool paused_ = false;
+};
+
+
+// NeneInput
+// SDL イベントを1フレームに1回だけアクション（"jump" など）の状態に翻訳する
+// キーコンフィグは黒板の文字列 "input.<アクション名>" に SDL のスキャンコード名をカンマ区切りで持つ（例: "Space,Up"）
+// 書き換えは購読で受け取り, スキャンコード→アクションのビット列の表に作り直す（翻訳は表を1回引くだけ）
+using NeneActionId = std::uint32_t;
+using NeneActionMask = std::uint64_t;
+class NeneInput {
+public:
+    static constexpr std::size_t kMaxActions = 64;
+    explicit NeneInput(std::shared_ptr<NeneBlackboard> blackboard) : blackboard_(std::move(blackboard)) {}
+    NeneInput(const NeneInput&) = delete;
+    NeneInput& operator=(const NeneInput&) = delete;
+    // アクション登録（同じ名前なら同じ id）. default_keys は黒板が空のときだけ書く
+    NeneActionId action(const std::string& name, const std::string& default_keys = ""); // →.cpp
+    bool has_action(const std::string& name) const { return ids_.find(name) != ids_.end(); }
+    const std::string& action_name(NeneActionId id) const { return names_.at(id); }
+    std::size_t action_count() const { return names_.size(); }
+    // キーコンフィグの書き換え（黒板に書く. 表への反映は次の flush）
+    void bind(NeneActionId id, const std::string& keys); // →.cpp
+    // フレーム処理（ルートが SDL イベントの前後で呼ぶ）
+    void begin_frame() {
+        down_events_ = 0;
+        up_events_ = 0;
+    }
+    void handle_event(const SDL_Event& ev); // →.cpp
+    void end_frame(); // →.cpp
+    // 状態
+    bool pressed(NeneActionId id) const  { return (pressed_ >> id) & 1u; }  // このフレームで押した
+    bool held(NeneActionId id) const     { return (held_ >> id) & 1u; }     // 押している
+    bool released(NeneActionId id) const { return (released_ >> id) & 1u; } // このフレームで離した
+    NeneActionMask pressed_mask() const  { return pressed_; }
+    NeneActionMask held_mask() const     { return held_; }
+    NeneActionMask released_mask() const { return released_; }
+    // キーの押下状態を捨てる（フォーカスを失ったときなど）
+    void clear(); // →.cpp
+    // 状態を直接入れる（記録の再生用. SDL イベントは使わない）
+    void set_frame(NeneActionMask held, NeneActionMask pressed, NeneActionMask released) {
+        held_ = held;
+        pressed_ = pressed;
+        released_ = released;
+    }
+private:
+    void compile_(NeneActionId id, const std::string& keys); // →.cpp
+    std::shared_ptr<NeneBlackboard> blackboard_;
+    std::unordered_map<std::string, NeneActionId> ids_;
+    std::vector<std::string> names_;
+    std::vector<NeneBBKey<std::string>> keys_;
+    std::vector<NeneBBSubscription> subs_;
+    std::vector<std::vector<SDL_Scancode>> bound_;                  // アクションごとの割り当て（表の作り直し用）
+    std::array<NeneActionMask, SDL_SCANCODE_COUNT> table_{};        // スキャンコード→アクション
+    std::vector<SDL_Scancode> down_;                                // 押されているキー
+    NeneActionMask held_ = 0;
+    NeneActionMask pressed_ = 0;
+    NeneActionMask released_ = 0;
+    NeneActionMask down_events_ = 0; // 同じフレームで押して離しても取りこぼさないように
+    NeneActionMask up_events_ = 0;
+};
+
+
+// NeneInputRecorder / NeneInputReplay
+// 入力の記録と再生（性能の回帰を同じプレイで測る用）
+// 記録は1フレームごとのアクションの状態（held/pressed/released）. 同じ状態が続く間はまとめて1件にする
+// ファイル: "NNREC" 版数(1) シード(u32) dt(f32), 以降は
+//   0: フレーム  varint(続いたフレーム数) varint(held) varint(pressed) varint(released)
+//   1: アクション名 varint(id) varint(長さ) 文字列（初めて出てきたときだけ）
+class NeneInputRecorder {
+public:
+    NeneInputRecorder(const std::string& path, std::uint32_t seed, float fixed_dt); // →.cpp
+    ~NeneInputRecorder(); // →.cpp
+    NeneInputRecorder(const NeneInputRecorder&) = delete;
+    NeneInputRecorder& operator=(const NeneInputRecorder&) = delete;
+    // 1フレーム分（NeneInput::end_frame の後に呼ぶ）
+    void record(const NeneInput& input); // →.cpp
+    // 書き残しを出して閉じる
+    void close(); // →.cpp
+    std::uint64_t frames() const { return frames_; }
+private:
+    void flush_run_(); // →.cpp
+    std::ofstream out_;
+    std::size_t named_ = 0; // 名前を書いたアクション数
+    NeneActionMask held_ = 0;
+    NeneActionMask pressed_ = 0;
+    NeneActionMask released_ = 0;
+    std::uint64_t run_ = 0;
+    std::uint64_t frames_ = 0;
+};
+class NeneInputReplay {
+public:
+    explicit NeneInputReplay(const std::string& path); // →.cpp（読めなければ throw）
+    std::uint32_t seed() const { return seed_; }
+    float fixed_dt() const { return fixed_dt_; }
+    // 次のフレームの状態を input に入れる. 記録が尽きたら false
+    bool next(NeneInput& input); // →.cpp
+    std::uint64_t frames() const { return frames_; }
+private:
+    NeneActionMask remap_(NeneActionMask recorded, NeneInput& input); // →.cpp
+    std::ifstream in_;
+    std::uint32_t seed_ = 0;
+    float fixed_dt_ = 0.0f;
+    std::vector<std::string> names_;  // 記録時の id -> 名前
+    NeneActionMask held_ = 0;
+    NeneActionMask pressed_ = 0;
+    NeneActionMask released_ = 0;
+    std::uint64_t run_ = 0;
+    bool first_of_run_ = false;
+    std::uint64_t frames_ = 0;
+};
+
+
+// NeneRandom
+// 乱数サービス. ルートの種から名前ごとに独立したストリームを作る（同じ種なら同じ並び）
+class NeneRandom {
+public:
+    explicit NeneRandom(std::uint64_t seed = 0) { reseed(seed); }
+    void reseed(std::uint64_t seed) {
+        nene_require_serial("NeneRandom::reseed");
+        seed_ = seed;
+        shared_.reseed(seed);
+    }
+    std::uint64_t seed() const { return seed_; }
+    // 名前からストリームを作る（ノード名など. 同じ名前なら同じストリーム）
+    NeneRng stream(std::string_view key) const {
+        // FNV-1a で名前を混ぜてから種と合わせる
+        std::uint64_t h = 0xcbf29ce484222325ull;
+        for (unsigned char c : key) {
+            h ^= c;
+            h *= 0x100000001b3ull;
+        }
+        return stream(h);
+    }
+    NeneRng stream(std::uint64_t id) const {
+        std::uint64_t x = seed_ ^ (id * 0x9e3779b97f4a7c15ull);
+        return NeneRng(NeneRng::splitmix64(x));
+    }
+    // ちょっと使うだけならこれ（呼ぶ順番で結果が変わるので, 並列パルスの中では throw. ストリームを使う）
+    NeneRng& shared() {
+        nene_require_serial("NeneRandom::shared");
+        return shared_;
+    }
+private:
+    std::uint64_t seed_ = 0;
+    NeneRng shared_;
+};
+
+
+// NeneWorkerPool
+// ワークスティーリングのスレッドプール（独立な子ノードの time_lapse を配る）
+class NeneWorkerPool {
+public:
+    // スレッドは最初に並列で回すときに起こす（使わなければ作らない）
+    explicit NeneWorkerPool(unsigned worker_count = 0); // →.cpp（0 ならコア数-1）
+    ~NeneWorkerPool(); // →.cpp
+    NeneWorkerPool(const NeneWorkerPool&) = delete;
+    NeneWorkerPool& operator=(const NeneWorkerPool&) = delete;
+    // fn(0)..fn(n-1) を並列に実行して全部終わるまで待つ（呼んだスレッドも手伝う）
+    // タスクの中から呼ばないこと. 例外は最初の1つを投げ直す
+    // タスクの間は nene_in_parallel_task() が true になる
+    void parallel_for(std::size_t n, const std::function<void(std::size_t)>& fn); // →.cpp
+    unsigned thread_count() const { return worker_count_ + 1; }
+private:
+    struct Job {
+        const std::function<void(std::size_t)>* fn = nullptr;
+        std::atomic<std::size_t> remaining{ 0 };
+        std::mutex error_mutex;
+        std::exception_ptr error;
+    };
+    struct Task {
+        Job* job;
+        std::size_t index;
+    };
+    // 自分のキューは後ろから取り, 空なら他のキューの前から盗む
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+    bool run_one_(std::size_t self); // →.cpp
+    void worker_main_(std::size_t self); // →.cpp
+    void start_workers_(); // →.cpp
+    unsigned worker_count_ = 0;
+    std::vector<std::unique_ptr<Queue>> queues_; // [0] は parallel_for を呼んだスレッド用
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::uint64_t job_seq_ = 0;
+    bool stop_ = false;
+    std::mutex call_mutex_; // parallel_for は同時に1つ
+};
+
+
 // NeneImageLoader
-class NeneImageLoader {
+// 非同期読み込みの状態
+enum class NeneAssetState : std::uint8_t {
+    Queued,   // デコード待ち
+    Decoded,  // ワーカーでデコード済み（アップロード待ち）
+    Ready,    // テクスチャ化済み
+    Failed
+};
+
+// テクスチャの読み込み単位（ハンドルはこれの shared_ptr）
+struct NeneTextureSlot {
+    std::string path;
+    std::atomic<NeneAssetState> state{ NeneAssetState::Queued };
+    SDL_Surface* surface = nullptr;    // ワーカーがデコードした画像（アップロード後に解放）
+    SDL_Texture* texture = nullptr;    // レンダースレッドで作る
+    std::string error;
+    std::vector<std::string> notify;   // 完了時にメールを送るノード名
+    std::size_t bytes = 0;             // テクスチャの推定メモリ量
+    bool pinned = false;               // 生ポインタで渡したものは追い出さない
+    bool ready() const { return state.load() == NeneAssetState::Ready; }
+    bool failed() const { return state.load() == NeneAssetState::Failed; }
+    SDL_Texture* get() const { return ready() ? texture : nullptr; }
+};
+using NeneTextureHandle = std::shared_ptr<NeneTextureSlot>;
+
+// テクスチャキャッシュ
+// バイト予算を超えたら, 誰もハンドルを持っていないものを古い順に追い出す
+struct NeneCacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    std::size_t bytes_resident = 0;
+    std::size_t entries = 0;
+};
+
+template <class Key, class Hash = std::hash<Key>>
+class NeneTextureCache {
 public:
-    explicit NeneImageLoader(SDL_Renderer* renderer)
-        : renderer_(renderer) {
-        if (!renderer_) {
-            throw std::runtime_error("NeneImageLoader: renderer is null");
+    explicit NeneTextureCache(std::size_t budget_bytes) : budget_(budget_bytes) {}
+    ~NeneTextureCache() { clear(); }
+    NeneTextureCache(const NeneTextureCache&) = delete;
+    NeneTextureCache& operator=(const NeneTextureCache&) = delete;
+    // 見つかったら最近使った扱いにする（統計に数える）
+    NeneTextureHandle find(const Key& key) {
+        auto it = map_.find(key);
+        if (it == map_.end()) {
+            ++stats_.misses;
+            return nullptr;
         }
-        // SDL3_image では IMG_Init / IMG_Quit は不要
+        ++stats_.hits;
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+        return it->second.slot;
+    }
+    // 統計にも LRU にも触らない参照
+    const NeneTextureSlot* peek(const Key& key) const {
+        auto it = map_.find(key);
+        return (it == map_.end()) ? nullptr : it->second.slot.get();
     }
-    ~NeneImageLoader() {
-        for (auto& [path, tex] : cache_) {
-            if (tex) SDL_DestroyTexture(tex);
+    void insert(const Key& key, NeneTextureHandle slot) {
+        lru_.push_front(key);
+        auto [it, inserted] = map_.emplace(key, Entry{ std::move(slot), lru_.begin(), 0 });
+        if (!inserted) {
+            lru_.pop_front();
+            throw std::runtime_error("NeneTextureCache: duplicated key");
         }
-        cache_.clear();
-        // SDL3_image では IMG_Quit も不要
-    }
-    SDL_Texture* get_texture(const std::string& path) {
-        auto it = cache_.find(path);
-        if (it != cache_.end()) return it->second;
-        SDL_Texture* tex = IMG_LoadTexture(renderer_, path.c_str());
-        if (!tex) {
-            throw std::runtime_error(std::string("[NeneImageLoader] IMG_LoadTexture failed '")
-                                     + path + "': " + SDL_GetError());
+        ++stats_.entries;
+        set_bytes(key, it->second.slot->bytes);
+    }
+    // テクスチャ化したときにサイズを反映する
+    void set_bytes(const Key& key, std::size_t bytes) {
+        auto it = map_.find(key);
+        if (it == map_.end()) return;
+        stats_.bytes_resident -= it->second.bytes;
+        it->second.bytes = bytes;
+        stats_.bytes_resident += bytes;
+    }
+    // 予算まで追い出す（参照中・固定・読み込み中のものは残す）
+    void trim() {
+        for (auto it = lru_.end(); it != lru_.begin() && stats_.bytes_resident > budget_; ) {
+            --it;
+            auto mit = map_.find(*it);
+            Entry& e = mit->second;
+            if (e.slot.use_count() > 1 || e.slot->pinned) continue;
+            const NeneAssetState st = e.slot->state.load();
+            if (st == NeneAssetState::Queued || st == NeneAssetState::Decoded) continue;
+            destroy_(*e.slot);
+            stats_.bytes_resident -= e.bytes;
+            --stats_.entries;
+            ++stats_.evictions;
+            map_.erase(mit);
+            it = lru_.erase(it);
         }
-        cache_.emplace(path, tex);
-        return tex;
     }
+    void clear() {
+        for (auto& [key, e] : map_) destroy_(*e.slot);
+        map_.clear();
+        lru_.clear();
+        stats_.bytes_resident = 0;
+        stats_.entries = 0;
+    }
+    void set_budget(std::size_t bytes) { budget_ = bytes; }
+    std::size_t budget() const { return budget_; }
+    const NeneCacheStats& stats() const { return stats_; }
+private:
+    struct Entry {
+        NeneTextureHandle slot;
+        typename std::list<Key>::iterator lru;
+        std::size_t bytes = 0;
+    };
+    static void destroy_(NeneTextureSlot& slot) {
+        if (slot.surface) SDL_DestroySurface(slot.surface);
+        if (slot.texture) SDL_DestroyTexture(slot.texture);
+        slot.surface = nullptr;
+        slot.texture = nullptr;
+    }
+    std::size_t budget_;
+    std::list<Key> lru_; // 先頭ほど最近使った
+    std::unordered_map<Key, Entry, Hash> map_;
+    NeneCacheStats stats_;
+};
+
+// シーンが使うアセットの一覧（切替前に温めておく用）
+struct NeneAssetManifest {
+    std::vector<std::string> textures;
+};
+
+// スプライト（テクスチャ内の名前付き領域. ロード時に一度だけ解決する）
+struct NeneSprite {
+    SDL_Texture* texture = nullptr;
+    SDL_FRect src{};
+};
+
+// アトラスに詰める画像
+struct NeneAtlasEntry {
+    std::string name;  // スプライト名
+    std::string path;  // 画像ファイル
+};
 
+class NeneImageLoader {
+public:
+    explicit NeneImageLoader(SDL_Renderer* renderer, int worker_count = 2); // →.cpp
+    ~NeneImageLoader(); // →.cpp
+    // 読み込み・登録・update は並列パルスの中からは呼べない（throw. init_node で取っておく）
+    // 同期取得（未ロードならその場で読む. 非同期で読み込み中ならそれを待つ）
+    // 生ポインタを返すのでローダーが生きている間は追い出さない
+    SDL_Texture* get_texture(const std::string& path); // →.cpp
+    // 同期取得（ハンドルを持っている間だけ固定され, 手放すと予算超過時に追い出される）
+    NeneTextureHandle acquire_texture(const std::string& path); // →.cpp
+    // 非同期取得（デコードはワーカー、アップロードは update で行う）
+    // notify_to を渡すと完了時に "texture_ready"（失敗時は "texture_failed"）メールが届く. body はパス
+    NeneTextureHandle load_async(const std::string& path, const std::string& notify_to = ""); // →.cpp
+    // マニフェストをまとめて先読み. 全部終わったら notify_to に "preload_done"（body は tag）
+    void preload(const NeneAssetManifest& manifest, const std::string& notify_to = "", const std::string& tag = ""); // →.cpp
+    bool is_loaded(const NeneAssetManifest& manifest) const; // →.cpp
+    // レンダースレッドで毎フレーム呼ぶ. デコード済みの画像を予算内でテクスチャ化する
+    void update(NeneMailServer& mail_server, Uint64 budget_ns = 2'000'000); // →.cpp
+    bool idle() const; // →.cpp
+    // キャッシュ予算と統計
+    void set_cache_budget(std::size_t bytes) {
+        nene_require_serial("NeneImageLoader::set_cache_budget");
+        cache_.set_budget(bytes);
+        cache_.trim();
+    }
+    const NeneCacheStats& cache_stats() const { return cache_.stats(); }
+    // --- スプライト登録 ---
+    // 既存のシート画像の一部に名前を付ける
+    void register_sprite(const std::string& name, const std::string& sheet_path, SDL_FRect src); // →.cpp
+    // 画像をまとめて大きなテクスチャに詰め、各画像を name で登録する. 作ったページ数を返す
+    int build_atlas(const std::vector<NeneAtlasEntry>& entries, int page_size = 2048, int padding = 1); // →.cpp
+    // 名前からテクスチャ+src を引く（無ければ throw）
+    NeneSprite sprite(const std::string& name) const; // →.cpp
+    bool has_sprite(const std::string& name) const { return sprites_.find(name) != sprites_.end(); }
 private:
+    struct PreloadGroup {
+        std::string notify_to;
+        std::string tag;
+        std::vector<NeneTextureHandle> items;
+    };
+    void start_workers_(); // →.cpp
+    void worker_main_();
+    void finish_now_(const NeneTextureHandle& slot);
+    void upload_(NeneTextureSlot& slot);
     SDL_Renderer* renderer_;
-    std::unordered_map<std::string, SDL_Texture*> cache_;
+    int worker_count_ = 1;
+    NeneTextureCache<std::string> cache_{ 256u * 1024u * 1024u };
+    std::vector<PreloadGroup> groups_;
+    std::vector<NeneTextureHandle> notify_slots_; // 完了通知待ち
+    // スプライト
+    std::unordered_map<std::string, NeneSprite> sprites_;
+    std::vector<SDL_Texture*> atlas_pages_;
+    // ワーカースレッド
+    std::vector<std::thread> workers_;
+    mutable std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    std::deque<NeneTextureHandle> work_queue_;   // デコード待ち
+    std::deque<NeneTextureHandle> done_queue_;   // アップロード待ち
+    int decoding_ = 0;                           // ワーカーがデコード中の数
+    bool stopping_ = false;
 };
 
 
 // NeneFontLoader
+// フォント（パス+サイズ）を登録順の番号にしたもの
+using NeneFontId = std::uint32_t;
+
 struct FontKey {
+    NeneFontId font;
     std::string text;
-    int fontSize;
     SDL_Color color;
     bool operator==(FontKey const& o) const {
-        return text == o.text
-            && fontSize == o.fontSize
+        return font == o.font
             && color.r == o.color.r
             && color.g == o.color.g
             && color.b == o.color.b
-            && color.a == o.color.a;
+            && color.a == o.color.a
+            && text == o.text;
     }
 };
 
 struct FontKeyHash {
     std::size_t operator()(FontKey const& k) const {
         std::size_t h1 = std::hash<std::string>()(k.text);
-        std::size_t h2 = std::hash<int>()(k.fontSize);
+        std::size_t h2 = std::hash<NeneFontId>()(k.font);
         std::size_t h3 = (static_cast<std::size_t>(k.color.r) << 24)
                        | (static_cast<std::size_t>(k.color.g) << 16)
                        | (static_cast<std::size_t>(k.color.b) << 8)
@@ -466,15 +1258,120 @@ struct FontKeyHash {
     }
 };
 
+// テキストテクスチャをノードが専有するハンドル
+// 同じ文字列の set_text は何もしない. 変わったときも大きさが収まれば同じテクスチャに書き直す
+class NeneTextHandle {
+public:
+    NeneTextHandle() = default;
+    NeneTextHandle(SDL_Renderer* renderer, TTF_Font* font, SDL_Color color); // →.cpp
+    ~NeneTextHandle(); // →.cpp
+    NeneTextHandle(NeneTextHandle&& o) noexcept; // →.cpp
+    NeneTextHandle& operator=(NeneTextHandle&& o) noexcept; // →.cpp
+    NeneTextHandle(const NeneTextHandle&) = delete;
+    NeneTextHandle& operator=(const NeneTextHandle&) = delete;
+    void set_text(std::string_view text); // →.cpp
+    void set_color(SDL_Color color);      // →.cpp
+    const std::string& text() const { return text_; }
+    SDL_Texture* texture() const { return tex_; }
+    const SDL_FRect& src() const { return src_; } // テクスチャ内で使っている範囲
+    float width() const { return src_.w; }
+    float height() const { return src_.h; }
+    // (x, y) を左上にして描く
+    void draw(float x, float y) const {
+        if (!tex_ || src_.w <= 0.0f) return;
+        const SDL_FRect dst{ x, y, src_.w, src_.h };
+        SDL_RenderTexture(renderer_, tex_, &src_, &dst);
+    }
+    explicit operator bool() const { return font_ != nullptr; }
+private:
+    void rerender_(); // →.cpp
+    void release_();  // →.cpp
+    SDL_Renderer* renderer_ = nullptr;
+    TTF_Font* font_ = nullptr;
+    SDL_Color color_{ 255, 255, 255, 255 };
+    std::string text_;
+    SDL_Texture* tex_ = nullptr;
+    int cap_w_ = 0;
+    int cap_h_ = 0;
+    SDL_FRect src_{ 0.0f, 0.0f, 0.0f, 0.0f };
+};
+
+// グリフアトラス（フォント+サイズごとに1つ）
+// 文字は初回だけラスタライズしてページテクスチャに詰め, 文字列は四角形の一括描画で出す
+class NeneGlyphAtlas {
+public:
+    NeneGlyphAtlas(SDL_Renderer* renderer, TTF_Font* font, int page_size = 512); // →.cpp
+    ~NeneGlyphAtlas(); // →.cpp
+    NeneGlyphAtlas(const NeneGlyphAtlas&) = delete;
+    NeneGlyphAtlas& operator=(const NeneGlyphAtlas&) = delete;
+    // (x, y) を左上にして描く. 同じページの文字は SDL_RenderGeometry 1回にまとめる
+    void draw(std::string_view text, float x, float y, SDL_Color color); // →.cpp
+    // 描画サイズ（幅, 行の高さ）
+    SDL_FPoint measure(std::string_view text); // →.cpp
+    float line_height() const { return static_cast<float>(line_h_); }
+private:
+    struct Glyph {
+        SDL_FRect src{};     // ページ内の位置（ラスタライズ結果の全体）
+        float advance = 0.0f;
+        int page = -1;       // -1 なら描くものが無い（空白など）
+    };
+    const Glyph& glyph_(std::uint32_t cp); // →.cpp
+    Glyph rasterize_(std::uint32_t cp);    // →.cpp
+    float kerning_(std::uint32_t prev, std::uint32_t cp) const; // →.cpp
+    SDL_Renderer* renderer_;
+    TTF_Font* font_;
+    int page_size_;
+    int line_h_ = 0;
+    // ページと棚詰めの状態
+    std::vector<SDL_Texture*> pages_;
+    int pen_x_ = 0;
+    int pen_y_ = 0;
+    int shelf_h_ = 0;
+    // グリフ（ASCII は配列で引く）
+    Glyph ascii_[128]{};
+    bool ascii_ready_[128]{};
+    std::unordered_map<std::uint32_t, Glyph> others_;
+    // 描画用の使い回しバッファ（ページごと）
+    std::vector<std::vector<SDL_Vertex>> verts_;
+    std::vector<std::vector<int>> indices_;
+};
+
 class NeneFontLoader {
 public:
     explicit NeneFontLoader(SDL_Renderer* renderer);
     ~NeneFontLoader();
-    TTF_Font* get_font(const std::string& fontPath, int fontSize);
+    // フォントを番号にする（初回だけ開く. init_node で1回取っておく）
+    // 開く・テクスチャを作る操作は並列パルスの中からは呼べない（throw）
+    NeneFontId font_id(const std::string& fontPath, int fontSize);
+    TTF_Font* font(NeneFontId id) const { return fonts_.at(id); }
+    TTF_Font* get_font(const std::string& fontPath, int fontSize) { return font(font_id(fontPath, fontSize)); }
+    // 生ポインタを返すのでローダーが生きている間は追い出さない
     SDL_Texture* get_text_texture(const std::string& fontPath, int fontSize,
                                   const std::string& text, SDL_Color color);
+    // ハンドル版（手放すと予算超過時に追い出される）
+    NeneTextureHandle acquire_text(NeneFontId font, const std::string& text, SDL_Color color);
+    NeneTextureHandle acquire_text(const std::string& fontPath, int fontSize,
+                                   const std::string& text, SDL_Color color) {
+        return acquire_text(font_id(fontPath, fontSize), text, color);
+    }
+    // ノード専有のテキスト（キャッシュを通さない）
+    NeneTextHandle make_text(NeneFontId font, SDL_Color color, std::string_view text = {});
+    // グリフアトラス（毎フレーム変わる文字列はこちらで描く. init_node で1回取っておく）
+    NeneGlyphAtlas* glyph_atlas(NeneFontId font);
+    NeneGlyphAtlas* glyph_atlas(const std::string& fontPath, int fontSize) {
+        return glyph_atlas(font_id(fontPath, fontSize));
+    }
+    // キャッシュ予算と統計
+    void set_cache_budget(std::size_t bytes) {
+        nene_require_serial("NeneFontLoader::set_cache_budget");
+        textCache_.set_budget(bytes);
+        textCache_.trim();
+    }
+    const NeneCacheStats& cache_stats() const { return textCache_.stats(); }
 private:
     SDL_Renderer* renderer_;
-    std::unordered_map<std::string, TTF_Font*> fontCache_;
-    std::unordered_map<FontKey, SDL_Texture*, FontKeyHash> textCache_;
+    std::unordered_map<std::string, NeneFontId> fontIds_;
+    std::vector<TTF_Font*> fonts_;                            // NeneFontId で引く
+    std::vector<std::unique_ptr<NeneGlyphAtlas>> glyphAtlases_; // NeneFontId で引く
+    NeneTextureCache<FontKey, FontKeyHash> textCache_{ 16u * 1024u * 1024u };
 };
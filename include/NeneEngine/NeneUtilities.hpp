@@ -10,4 +10,81 @@
 #include <cmath>
 #include <cstdint>
 #include <limits>
-#include <functional>
\ No newline at end of file
+#include <functional>
+#include <algorithm>
+#include <SDL3/SDL.h>
+
+// 矩形同士が重なっているか（辺が接しているだけなら重なっていない扱い）
+inline bool nene_rect_intersects(const SDL_FRect& a, const SDL_FRect& b) {
+    if (a.x + a.w <= b.x) return false;
+    if (b.x + b.w <= a.x) return false;
+    if (a.y + a.h <= b.y) return false;
+    if (b.y + b.h <= a.y) return false;
+    return true;
+}
+
+// 矩形パッキング（アトラス作成用. 高さ順に並べて棚詰めする）
+struct NenePackItem {
+    int w = 0;
+    int h = 0;
+    // 結果
+    int x = 0;
+    int y = 0;
+    int page = -1; // 入らなかったら -1 のまま
+};
+
+// items を page_w x page_h のページに詰める. 使ったページ数を返す
+inline int nene_pack_rects(std::vector<NenePackItem>& items, int page_w, int page_h, int padding = 1) {
+    std::vector<std::size_t> order(items.size());
+    for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return items[a].h > items[b].h;
+    });
+    int pages = 0;
+    int x = 0, y = 0, shelf_h = 0;
+    for (std::size_t idx : order) {
+        NenePackItem& it = items[idx];
+        it.page = -1;
+        const int w = it.w + padding;
+        const int h = it.h + padding;
+        if (w > page_w || h > page_h) continue; // 大きすぎる
+        if (pages == 0) pages = 1;
+        if (x + w > page_w) { // 次の棚へ
+            x = 0;
+            y += shelf_h;
+            shelf_h = 0;
+        }
+        if (y + h > page_h) { // 次のページへ
+            ++pages;
+            x = 0;
+            y = 0;
+            shelf_h = 0;
+        }
+        it.x = x;
+        it.y = y;
+        it.page = pages - 1;
+        x += w;
+        if (h > shelf_h) shelf_h = h;
+    }
+    return pages;
+}
+
+// UTF-8 を1文字読んで i を進める（壊れたバイトは U+FFFD）
+inline std::uint32_t nene_utf8_next(std::string_view s, std::size_t& i) {
+    const auto b0 = static_cast<unsigned char>(s[i++]);
+    if (b0 < 0x80) return b0;
+    int extra = 0;
+    std::uint32_t cp = 0;
+    if ((b0 & 0xE0) == 0xC0) { extra = 1; cp = b0 & 0x1F; }
+    else if ((b0 & 0xF0) == 0xE0) { extra = 2; cp = b0 & 0x0F; }
+    else if ((b0 & 0xF8) == 0xF0) { extra = 3; cp = b0 & 0x07; }
+    else return 0xFFFD;
+    for (int k = 0; k < extra; ++k) {
+        if (i >= s.size()) return 0xFFFD;
+        const auto b = static_cast<unsigned char>(s[i]);
+        if ((b & 0xC0) != 0x80) return 0xFFFD;
+        cp = (cp << 6) | (b & 0x3F);
+        ++i;
+    }
+    return cp;
+}
@@ -3,14 +3,22 @@
 #include <queue>
 #include <stdexcept>
 #include <algorithm>
+#include <random>
 #include <SDL3_image/SDL_image.h>
 #include <NeneEngine/NeneNode.hpp>
+#include <NeneEngine/NeneUtilities.hpp>
 
 
 // NeneNode
 NeneNode::NeneNode(std::string node_name)
     : name(std::move(node_name)) {}
 
+// 持ち主として登録したタイマーとアニメーションも一緒に消す
+NeneNode::~NeneNode() {
+    if (timer) timer->cancel_owner(this);
+    if (animation) animation->remove_owner(this);
+}
+
 // ターミナル出力
 void NeneNode::nnlog(std::string_view msg) const {
     std::cout << "[" << this->name << "] " << msg << "\n";
@@ -44,7 +52,7 @@ void NeneNode::dump_tree_impl(std::ostream& os, const std::string& prefix, bool
        << prefix
        << (is_last ? "└─ " : "├─ ")
        << "[" << name << "]";
-    if (!valve_sdl_event && !valve_time_lapse && !valve_nene_mail && !valve_render) os << " (inactive)";
+    if (!valve_sdl_event && !valve_input && !valve_time_lapse && !valve_nene_mail && !valve_render) os << " (inactive)";
     else if (!valve_render) os << " (render off)";
     os << "\n";
     const std::string next_prefix = prefix + (is_last ? "   " : "│  ");
@@ -59,7 +67,32 @@ void NeneNode::dump_tree_impl(std::ostream& os, const std::string& prefix, bool
     }
 }
 
+// パルスの入口（外側にパルスが無いとき）で木の変更の積み先を用意し, 終わったらまとめて反映する
+template <class F>
+void NeneNode::pulse_entry_(F&& body) {
+    deferred_commands_() = &pulse_commands_;
+    try {
+        body();
+    } catch (...) {
+        deferred_commands_() = nullptr;
+        pulse_commands_.clear();
+        throw;
+    }
+    deferred_commands_() = nullptr;
+    // 反映中の throw（同名の子や init_node の失敗）でも残りを次のパルスに持ち越さない
+    try {
+        apply_commands_(pulse_commands_);
+    } catch (...) {
+        pulse_commands_.clear();
+        throw;
+    }
+}
+
 void NeneNode::pulse_sdl_event(const SDL_Event& ev) {
+    if (!deferred_commands_()) {
+        pulse_entry_([&] { pulse_sdl_event(ev); });
+        return;
+    }
     if (!valve_sdl_event) return;
     handle_sdl_event(ev);
     for (auto& kv : children) {
@@ -67,14 +100,245 @@ void NeneNode::pulse_sdl_event(const SDL_Event& ev) {
     }
 }
 
+void NeneNode::pulse_input(const NeneInput& in) {
+    if (!deferred_commands_()) {
+        pulse_entry_([&] { pulse_input(in); });
+        return;
+    }
+    if (!valve_input) return;
+    handle_input(in);
+    for (auto& kv : children) {
+        if (kv.second) kv.second->pulse_input(in);
+    }
+}
+
 void NeneNode::pulse_time_lapse(const float& dt) {
-    if (!valve_time_lapse) return;
+    if (!deferred_commands_()) {
+        pulse_entry_([&] { pulse_time_lapse(dt); });
+        return;
+    }
+    // 期限が来たタイマーをまとめて呼ぶ（木の一番上で1回. 止まっていた枝の分は期限をずらす）
+    if (!parent && timer) {
+        timer->advance(dt, [](const void* owner) {
+            NeneTimer::OwnerClock st;
+            for (auto* n = static_cast<const NeneNode*>(owner); n; n = n->parent) {
+                st.paused = st.paused || !n->valve_time_lapse;
+                st.skipped += n->time_skipped_;
+            }
+            return st;
+        });
+    }
+    if (!valve_time_lapse) {
+        time_skipped_ += dt;
+        return;
+    }
     handle_time_lapse(dt);
+    // 独立な子は並列に（入れ子の並列はしない）
+    if (children_independent_ && worker_pool && children.size() > 1 && !in_parallel_()) {
+        pulse_children_parallel_(dt);
+        return;
+    }
     for (auto& kv : children) {
         if (kv.second) kv.second->pulse_time_lapse(dt);
     }
 }
 
+bool NeneNode::time_paused() const {
+    for (const NeneNode* node = this; node; node = node->parent) {
+        if (!node->valve_time_lapse) return true;
+    }
+    return false;
+}
+
+double NeneNode::time_skipped() const {
+    double sum = 0.0;
+    for (const NeneNode* node = this; node; node = node->parent) sum += node->time_skipped_;
+    return sum;
+}
+
+NeneTimerId NeneNode::set_timeout(float sec, std::function<void()> fn) {
+    if (!timer) nnthrow("set_timeout: timer service is not available (add the node to the tree first)");
+    if (in_parallel_()) nnthrow("set_timeout: not allowed during a parallel pulse");
+    return timer->after(sec, std::move(fn), this, time_skipped());
+}
+
+NeneTimerId NeneNode::set_interval(float sec, std::function<void()> fn) {
+    if (!timer) nnthrow("set_interval: timer service is not available (add the node to the tree first)");
+    if (in_parallel_()) nnthrow("set_interval: not allowed during a parallel pulse");
+    return timer->every(sec, std::move(fn), this, time_skipped());
+}
+
+bool NeneNode::cancel_timer(NeneTimerId id) {
+    if (!timer) return false;
+    if (in_parallel_()) {
+        // ホイールは並列中に書き換わらないので pending は読んでよい
+        if (!timer->pending(id)) return false;
+        Command cmd{ Command::Kind::CancelTimer, this };
+        cmd.timer_id = id;
+        deferred_commands_()->push_back(std::move(cmd));
+        return true;
+    }
+    return timer->cancel(id);
+}
+
+void NeneNode::clear_timers() {
+    if (!timer) return;
+    if (in_parallel_()) {
+        deferred_commands_()->emplace_back(Command::Kind::ClearTimers, this);
+        return;
+    }
+    timer->cancel_owner(this);
+}
+
+std::vector<NeneNode::Command>*& NeneNode::deferred_commands_() {
+    thread_local std::vector<Command>* commands = nullptr;
+    return commands;
+}
+
+bool& NeneNode::in_parallel_() {
+    thread_local bool parallel = false;
+    return parallel;
+}
+
+void NeneNode::pulse_children_parallel_(const float& dt) {
+    parallel_children_.clear();
+    for (auto& kv : children) {
+        if (kv.second) parallel_children_.push_back(kv.second.get());
+    }
+    if (parallel_commands_.size() < parallel_children_.size()) parallel_commands_.resize(parallel_children_.size());
+    auto run = [this, &dt](std::size_t i) {
+        // 子ごとに積み先を分けるので, 反映順はスレッド数に依らない
+        struct Restore {
+            std::vector<Command>* prev;
+            ~Restore() {
+                deferred_commands_() = prev;
+                in_parallel_() = false;
+            }
+        } restore{ deferred_commands_() };
+        deferred_commands_() = &parallel_commands_[i];
+        in_parallel_() = true;
+        NeneBlackboard::set_writer_rank(static_cast<std::uint32_t>(i));
+        parallel_children_[i]->pulse_time_lapse(dt);
+    };
+    try {
+        worker_pool->parallel_for(parallel_children_.size(), run);
+    } catch (...) {
+        // 途中までの積み残しを次のフレームに持ち越さない
+        NeneBlackboard::set_writer_rank(0);
+        for (auto& cmds : parallel_commands_) cmds.clear();
+        throw;
+    }
+    NeneBlackboard::set_writer_rank(0);
+    // 同期点（木の変更は外側のパルスの積み先へ回る）
+    for (std::size_t i = 0; i < parallel_children_.size(); ++i) {
+        apply_commands_(parallel_commands_[i]);
+    }
+}
+
+void NeneNode::apply_commands_(std::vector<Command>& buffer) {
+    // まだパルスの中なら木の変更はそちらへ回す
+    std::vector<Command>* const outer = deferred_commands_();
+    for (std::size_t i = 0; i < buffer.size(); ++i) {
+        Command& cmd = buffer[i];
+        switch (cmd.kind) {
+            case Command::Kind::Mail:
+                if (mail_server) mail_server->push(std::move(cmd.mail));
+                break;
+            case Command::Kind::ColliderPosition:
+                if (collision_world) collision_world->set_position(cmd.collider, cmd.position);
+                break;
+            case Command::Kind::RenderDirty:
+                if (cmd.target) cmd.target->mark_render_dirty();
+                break;
+            case Command::Kind::CancelTimer:
+                if (timer) timer->cancel(cmd.timer_id);
+                break;
+            case Command::Kind::ClearTimers:
+                if (cmd.target && timer) timer->cancel_owner(cmd.target);
+                break;
+            case Command::Kind::AddChild:
+                if (!cmd.target) break; // 宛先の枝はもう破棄した
+                if (outer) outer->push_back(std::move(cmd));
+                else cmd.target->add_child(std::move(cmd.node));
+                break;
+            case Command::Kind::RemoveChild:
+                if (!cmd.target) break;
+                if (outer) outer->push_back(std::move(cmd));
+                else if (auto node = cmd.target->detach_child_(cmd.name)) destroy_detached_(std::move(node), buffer, i + 1);
+                break;
+            case Command::Kind::ClearChildren: {
+                if (!cmd.target) break;
+                if (outer) {
+                    outer->push_back(std::move(cmd));
+                    break;
+                }
+                std::vector<std::unique_ptr<NeneNode>> detached;
+                for (auto& kv : cmd.target->children) {
+                    if (!kv.second) continue;
+                    kv.second->parent = nullptr;
+                    detached.push_back(std::move(kv.second));
+                }
+                cmd.target->children.clear();
+                cmd.target->mark_render_dirty();
+                for (auto& node : detached) destroy_detached_(std::move(node), buffer, i + 1);
+                break;
+            }
+        }
+    }
+    buffer.clear();
+}
+
+// 外したノードはその場で破棄する（直後の AddChild で来る次のシーンより先にデストラクタを走らせる）
+// 残りのコマンドが破棄する枝を宛先にしていたら無効にしておく
+void NeneNode::destroy_detached_(std::unique_ptr<NeneNode> node, std::vector<Command>& buffer, std::size_t from) {
+    if (from < buffer.size()) {
+        std::unordered_set<const NeneNode*> gone;
+        std::vector<const NeneNode*> stack{ node.get() };
+        while (!stack.empty()) {
+            const NeneNode* n = stack.back();
+            stack.pop_back();
+            gone.insert(n);
+            for (const auto& kv : n->children) {
+                if (kv.second) stack.push_back(kv.second.get());
+            }
+        }
+        for (std::size_t j = from; j < buffer.size(); ++j) {
+            Command& c = buffer[j];
+            const bool tree = c.kind == Command::Kind::AddChild || c.kind == Command::Kind::RemoveChild ||
+                              c.kind == Command::Kind::ClearChildren || c.kind == Command::Kind::RenderDirty ||
+                              c.kind == Command::Kind::ClearTimers;
+            if (tree && gone.count(c.target)) c.target = nullptr;
+        }
+    }
+    node.reset();
+}
+
+void NeneNode::send_mail(NeneMail&& mail) {
+    if (in_parallel_()) {
+        Command cmd{ Command::Kind::Mail, this };
+        cmd.mail = std::move(mail);
+        deferred_commands_()->push_back(std::move(cmd));
+        return;
+    }
+    if (mail_server) mail_server->push(std::move(mail));
+}
+
+void NeneNode::defer_render_dirty_() {
+    deferred_commands_()->emplace_back(Command::Kind::RenderDirty, this);
+}
+
+void NeneNode::set_collider_position(NeneCollisionWorld::ColliderId id, SDL_FPoint pos) {
+    if (!collision_world) return;
+    if (in_parallel_()) {
+        Command cmd{ Command::Kind::ColliderPosition, this };
+        cmd.collider = id;
+        cmd.position = pos;
+        deferred_commands_()->push_back(std::move(cmd));
+        return;
+    }
+    collision_world->set_position(id, pos);
+}
+
 // void NeneNode::pulse_nene_mail(const NeneMail& mail) {
 //     if (!valve_nene_mail) return;
 //     // 宛先が無い（ブロードキャスト）か、自分宛なら処理
@@ -88,34 +352,79 @@ void NeneNode::pulse_time_lapse(const float& dt) {
 // }
 
 void NeneNode::pulse_nene_mail(const NeneMail& mail) {
+    if (!deferred_commands_()) {
+        pulse_entry_([&] { pulse_nene_mail(mail); });
+        return;
+    }
     if (!valve_nene_mail) return;
     // 宛先が無い（ブロードキャスト）か、自分宛なら処理
     if (!mail.to.has_value() || mail.to.value() == this->name) {
-        handle_nene_mail(mail); // ここで children が増減してもOK
+        handle_nene_mail(mail); // children の増減はパルスの後で反映されるので, そのまま回してOK
     }
-    // children を直接イテレートしない（keyスナップショット方式）
-    std::vector<std::string> keys;
-    keys.reserve(children.size());
-    for (const auto& kv : children) keys.push_back(kv.first);
-    for (const auto& key : keys) {
-        auto it = children.find(key);
-        if (it == children.end()) continue;  // 消えてたらスキップ
-        if (!it->second) continue;
-        it->second->pulse_nene_mail(mail);
+    for (auto& kv : children) {
+        if (kv.second) kv.second->pulse_nene_mail(mail);
     }
 }
 
 // render_zの順でrender命令を実行
 void NeneNode::pulse_render(SDL_Renderer* renderer) {
     if (!renderer) return;
+    if (!deferred_commands_()) {
+        pulse_entry_([&] { pulse_render(renderer); });
+        return;
+    }
     if (render_cache_dirty_) {
         rebuild_render_cache_();
         render_cache_dirty_ = false;
     }
-    // キャッシュ順に描画（valve_renderがOFFなら飛ばす）
+    // カメラが無ければウィンドウ全体をそのまま描く
+    if (!camera) {
+        SDL_FRect view{ 0.0f, 0.0f, 0.0f, 0.0f };
+        if (blackboard) {
+            view.w = static_cast<float>(blackboard->window_w);
+            view.h = static_cast<float>(blackboard->window_h);
+        }
+        render_view_(renderer, view);
+        return;
+    }
+    int out_w = 0, out_h = 0;
+    if (!SDL_GetCurrentRenderOutputSize(renderer, &out_w, &out_h)) return;
+    // ビューポートごとに描画（変換はカメラが持つ）
+    for (std::size_t i = 0; i < camera->viewport_count(); ++i) {
+        const NeneViewport& vp = camera->viewport(i);
+        if (!vp.enabled) continue;
+        const bool full = (vp.screen.w <= 0.0f || vp.screen.h <= 0.0f);
+        if (!full) {
+            const SDL_Rect rect{
+                static_cast<int>(vp.screen.x), static_cast<int>(vp.screen.y),
+                static_cast<int>(vp.screen.w), static_cast<int>(vp.screen.h)
+            };
+            SDL_SetRenderViewport(renderer, &rect); // ビューポート外はクリップされる
+        }
+        camera->begin_view(vp, static_cast<float>(out_w), static_cast<float>(out_h));
+        render_view_(renderer, camera->visible_rect());
+        if (!full) SDL_SetRenderViewport(renderer, nullptr);
+    }
+}
+
+// キャッシュ順に描画（valve_renderがOFFなら飛ばす）
+void NeneNode::render_view_(SDL_Renderer* renderer, SDL_FRect view) {
+    const bool can_cull = (view.w > 0.0f && view.h > 0.0f);
+    int layer_z = 0;
+    bool layer_set = false;
+    SDL_FRect bounds{};
     for (NeneNode* n : render_cache_) {
         if (!n) continue;
         if (!n->valve_render) continue;
+        // render_z が変わったときだけパララックスを切り替える（キャッシュはz順）
+        if (camera && (!layer_set || n->render_z != layer_z)) {
+            layer_z = n->render_z;
+            layer_set = true;
+            camera->set_layer_z(layer_z);
+            view = camera->visible_rect();
+        }
+        // 画面外カリング（範囲を公開しているノードだけ）
+        if (can_cull && n->render_bounds(bounds) && !nene_rect_intersects(bounds, view)) continue;
         n->render(renderer);
     }
 }
@@ -137,6 +446,7 @@ void NeneNode::rebuild_render_cache_() const {
         NeneNode* n = q.front();
         q.pop();
         if (!n) continue;
+        if (n->parked_) continue; // 裏に置いた枝ごと外す
         items.push_back(Item{ n->render_z, seq++, n });
         for (auto& kv : n->children) {
             if (kv.second) q.push(kv.second.get());
@@ -157,6 +467,12 @@ void NeneNode::rebuild_render_cache_() const {
 
 void NeneNode::add_child(std::unique_ptr<NeneNode> child) {
     if (!child) return;
+    if (auto* cmds = deferred_commands_()) {
+        Command cmd{ Command::Kind::AddChild, this };
+        cmd.node = std::move(child);
+        cmds->push_back(std::move(cmd));
+        return;
+    }
     // 共有サービスを親から引き継ぐ
     child->mail_server = this->mail_server;
     child->asset_loader = this->asset_loader;
@@ -164,6 +480,12 @@ void NeneNode::add_child(std::unique_ptr<NeneNode> child) {
     child->path_service = this->path_service;
     child->blackboard = this->blackboard;
     child->collision_world = this->collision_world;
+    child->camera = this->camera;
+    child->worker_pool = this->worker_pool;
+    child->animation = this->animation;
+    child->timer = this->timer;
+    child->input = this->input;
+    child->random = this->random;
     // 親を設定
     child->parent = this;
     // 同名の兄弟は区別できないのでthrow
@@ -185,16 +507,36 @@ void NeneNode::add_child(std::unique_ptr<NeneNode> child) {
 }
 
 bool NeneNode::remove_child(const std::string& name) {
+    if (auto* cmds = deferred_commands_()) {
+        // 同じパルスで積んだ AddChild もまだ子に居ないだけなので消せる（反映は積んだ順なので追加の後に外れる）
+        const bool pending = std::any_of(cmds->begin(), cmds->end(), [&](const Command& c) {
+            return c.kind == Command::Kind::AddChild && c.target == this && c.node && c.node->name == name;
+        });
+        if (!pending && children.find(name) == children.end()) return false;
+        Command cmd{ Command::Kind::RemoveChild, this };
+        cmd.name = name;
+        cmds->push_back(std::move(cmd));
+        return true;
+    }
+    return detach_child_(name) != nullptr;
+}
+
+std::unique_ptr<NeneNode> NeneNode::detach_child_(const std::string& name) {
     auto it = children.find(name);
-    if (it == children.end()) return false;
-    if (it->second) it->second->parent = nullptr;
+    if (it == children.end()) return nullptr;
+    std::unique_ptr<NeneNode> node = std::move(it->second);
+    if (node) node->parent = nullptr;
     children.erase(it);
     // 描画順キャッシュを更新する必要がある
     mark_render_dirty();
-    return true;
+    return node;
 }
 
 void NeneNode::clear_children() {
+    if (auto* cmds = deferred_commands_()) {
+        cmds->emplace_back(Command::Kind::ClearChildren, this);
+        return;
+    }
     for (auto& kv : children) {
         if (kv.second) kv.second->parent = nullptr;
     }
@@ -239,6 +581,28 @@ NeneRoot::NeneRoot(std::string node_name, const char* title, int w, int h, Uint3
         this->blackboard->window_h = h;
     }
     this->collision_world = std::make_shared<NeneCollisionWorld>();
+    this->camera = std::make_shared<NeneCamera>();
+    this->worker_pool = std::make_shared<NeneWorkerPool>();
+    this->animation = std::make_shared<NeneAnimationSystem>();
+    this->timer = std::make_shared<NeneTimer>();
+    this->input = std::make_shared<NeneInput>(this->blackboard);
+    // 乱数の種（記録・再生で上書きされる. random_device を引くのは起動時の1回だけ）
+    seed_ = std::random_device{}();
+    this->random = std::make_shared<NeneRandom>(seed_);
+}
+
+void NeneRoot::record_to(const std::string& path, float fixed_dt) {
+    if (tree_built) nnthrow("record_to must be called before run");
+    record_path_ = path;
+    fixed_dt_ = fixed_dt;
+}
+
+void NeneRoot::replay_from(const std::string& path) {
+    if (tree_built) nnthrow("replay_from must be called before run");
+    replay_ = std::make_unique<NeneInputReplay>(path);
+    seed_ = replay_->seed();
+    fixed_dt_ = replay_->fixed_dt();
+    if (window) SDL_HideWindow(window);
 }
 
 NeneRoot::~NeneRoot() {
@@ -249,6 +613,9 @@ NeneRoot::~NeneRoot() {
 
 int NeneRoot::run() {
     if (!tree_built) {
+        if (random) random->reseed(seed_);
+        if (blackboard) blackboard->set(blackboard->key<int>("random_seed"), static_cast<int>(seed_));
+        if (!record_path_.empty()) recorder_ = std::make_unique<NeneInputRecorder>(record_path_, seed_, fixed_dt_);
         init_node();
         tree_built = true;
         nnlog("game tree initialized");
@@ -257,17 +624,42 @@ int NeneRoot::run() {
     running = true;
     nnlog("main loop start");
     Uint64 prev_ticks = SDL_GetTicks();
+    const Uint64 start_ns = SDL_GetTicksNS();
     while (running) {
-        // SDLイベント
+        // SDLイベント（再生中は閉じるなどのためにルートだけが見る）
+        if (input && !replay_) input->begin_frame();
         SDL_Event ev;
         while (SDL_PollEvent(&ev)) {
-            pulse_sdl_event(ev);
+            if (replay_) {
+                handle_sdl_event(ev);
+                continue;
+            }
+            if (input) input->handle_event(ev);
+            if (sdl_event_walk_) pulse_sdl_event(ev);
+            else handle_sdl_event(ev);
+        }
+        // NeneInput（イベントを翻訳したアクションを1回だけ流す. 再生中は記録から）
+        if (input) {
+            if (replay_) {
+                if (!replay_->next(*input)) break;
+            } else {
+                input->end_frame();
+            }
+            if (recorder_) recorder_->record(*input);
+            pulse_input(*input);
         }
         // 時間経過
         Uint64 now_ticks = SDL_GetTicks();
         float dt = static_cast<float>(now_ticks - prev_ticks) / 1000.0f;
         prev_ticks = now_ticks;
+        if (fixed_dt_ > 0.0f) dt = fixed_dt_;
         pulse_time_lapse(dt);
+        // アニメーションをまとめて進める（終了通知はメールで届く. 水門が閉じた枝の持ち主の分は止める）
+        if (animation && mail_server) {
+            animation->update(dt, *mail_server, [](const void* owner) { return static_cast<const NeneNode*>(owner)->time_paused(); });
+        }
+        // 非同期ロードのアップロード（完了通知はメールで届く）
+        if (asset_loader && mail_server) asset_loader->update(*mail_server);
         // NeneMail
         if (mail_server) {
             NeneMail mail;
@@ -275,6 +667,11 @@ int NeneRoot::run() {
                 pulse_nene_mail(mail);
             }
         }
+        // 黒板の下書きを確定して（ダブルバッファ時）, 変更を通知する（1フレームに1回まとめて. メール購読は次のフレームに届く）
+        if (blackboard) blackboard->commit();
+        if (blackboard && mail_server) blackboard->flush(*mail_server);
+        // 再生中は描画も待ちもしない
+        if (replay_) continue;
         // render (ここだけ幅優先)
         SDL_RenderClear(renderer);
         pulse_render(renderer);
@@ -282,6 +679,16 @@ int NeneRoot::run() {
         // ウェイト（後でFPS制御に置換する）
         SDL_Delay(16);
     }
+    if (recorder_) {
+        recorder_->close();
+        nnlog("recorded " + std::to_string(recorder_->frames()) + " frames to " + record_path_);
+    }
+    if (replay_) {
+        const double ms = static_cast<double>(SDL_GetTicksNS() - start_ns) / 1e6;
+        const std::uint64_t frames = replay_->frames();
+        nnlog("replayed " + std::to_string(frames) + " frames in " + std::to_string(ms) + " ms (" +
+              std::to_string(frames ? ms / static_cast<double>(frames) : 0.0) + " ms/frame)");
+    }
     nnlog("main loop end");
     return 0;
 }
@@ -354,3 +761,430 @@ void NeneFactory::handle_nene_mail(const NeneMail& mail) {
         return;
     }
 }
+
+// ねねタイルマップ
+NeneTilemap::NeneTilemap(std::string name, int tile_w, int tile_h, int cols, int rows)
+    : NeneNode(std::move(name)), tile_w_(tile_w), tile_h_(tile_h), cols_(cols), rows_(rows) {
+    if (tile_w_ <= 0 || tile_h_ <= 0 || cols_ <= 0 || rows_ <= 0) nnthrow("NeneTilemap: invalid size");
+    chunk_cols_ = (cols_ + kChunkTiles - 1) / kChunkTiles;
+    chunk_rows_ = (rows_ + kChunkTiles - 1) / kChunkTiles;
+    tiles_.assign(static_cast<std::size_t>(cols_) * rows_, 0);
+    chunks_.resize(static_cast<std::size_t>(chunk_cols_) * chunk_rows_);
+}
+
+NeneTilemap::~NeneTilemap() {
+    for (auto& c : chunks_) {
+        if (c.tex) SDL_DestroyTexture(c.tex);
+        c.tex = nullptr;
+    }
+    release_colliders_();
+}
+
+void NeneTilemap::set_tileset(SDL_Texture* tex) {
+    tileset_ = tex;
+    tileset_cols_ = 0;
+    if (tileset_) {
+        float tw = 0.0f, th = 0.0f;
+        if (!SDL_GetTextureSize(tileset_, &tw, &th)) nnthrow("NeneTilemap: SDL_GetTextureSize failed");
+        tileset_cols_ = static_cast<int>(tw) / tile_w_;
+    }
+    for (auto& c : chunks_) c.dirty = true;
+}
+
+void NeneTilemap::set_origin(SDL_FPoint p) {
+    origin_ = p;
+    if (colliders_enabled_) colliders_dirty_ = true;
+}
+
+void NeneTilemap::set_tile(int col, int row, Tile t) {
+    if (col < 0 || row < 0 || col >= cols_ || row >= rows_) return;
+    Tile& cur = tiles_[static_cast<std::size_t>(row) * cols_ + col];
+    if (cur == t) return;
+    if (colliders_enabled_ && is_solid_(cur) != is_solid_(t)) colliders_dirty_ = true;
+    cur = t;
+    chunks_[static_cast<std::size_t>(row / kChunkTiles) * chunk_cols_ + col / kChunkTiles].dirty = true;
+}
+
+NeneTilemap::Tile NeneTilemap::tile(int col, int row) const {
+    if (col < 0 || row < 0 || col >= cols_ || row >= rows_) return 0;
+    return tiles_[static_cast<std::size_t>(row) * cols_ + col];
+}
+
+void NeneTilemap::fill(Tile t) {
+    std::fill(tiles_.begin(), tiles_.end(), t);
+    for (auto& c : chunks_) c.dirty = true;
+    if (colliders_enabled_) colliders_dirty_ = true;
+}
+
+void NeneTilemap::set_solid(Tile t, bool v) {
+    if (t >= solid_.size()) solid_.resize(static_cast<std::size_t>(t) + 1, false);
+    if (solid_[t] == v) return;
+    solid_[t] = v;
+    if (colliders_enabled_) colliders_dirty_ = true;
+}
+
+void NeneTilemap::enable_colliders(std::uint32_t layer, std::uint32_t mask, NenePolygonColor color) {
+    colliders_enabled_ = true;
+    colliders_dirty_ = true;
+    collider_layer_ = layer;
+    collider_mask_ = mask;
+    collider_color_ = color;
+}
+
+void NeneTilemap::handle_time_lapse(const float&) {
+    // コライダーの作り直しは変更があったフレームに1回だけ
+    if (colliders_dirty_ && collision_world) {
+        rebuild_colliders_();
+        colliders_dirty_ = false;
+    }
+}
+
+bool NeneTilemap::render_bounds(SDL_FRect& out) const {
+    out = SDL_FRect{ origin_.x, origin_.y,
+                     static_cast<float>(cols_ * tile_w_), static_cast<float>(rows_ * tile_h_) };
+    return true;
+}
+
+void NeneTilemap::render(SDL_Renderer* r) {
+    if (!r || !tileset_ || tileset_cols_ <= 0) return;
+    const float chunk_w = static_cast<float>(kChunkTiles * tile_w_);
+    const float chunk_h = static_cast<float>(kChunkTiles * tile_h_);
+    // 見えているチャンクの範囲
+    int cx0 = 0, cy0 = 0, cx1 = chunk_cols_ - 1, cy1 = chunk_rows_ - 1;
+    if (camera) {
+        const SDL_FRect view = camera->visible_rect();
+        if (view.w > 0.0f && view.h > 0.0f) {
+            cx0 = std::max(cx0, static_cast<int>(std::floor((view.x - origin_.x) / chunk_w)));
+            cy0 = std::max(cy0, static_cast<int>(std::floor((view.y - origin_.y) / chunk_h)));
+            cx1 = std::min(cx1, static_cast<int>(std::floor((view.x + view.w - origin_.x) / chunk_w)));
+            cy1 = std::min(cy1, static_cast<int>(std::floor((view.y + view.h - origin_.y) / chunk_h)));
+        }
+    }
+    for (int cy = cy0; cy <= cy1; ++cy) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            Chunk& c = chunks_[static_cast<std::size_t>(cy) * chunk_cols_ + cx];
+            if (c.dirty) bake_chunk_(r, cx, cy, c);
+            if (!c.tex) continue; // 空チャンク
+            const SDL_FRect dst{ origin_.x + cx * chunk_w, origin_.y + cy * chunk_h, chunk_w, chunk_h };
+            draw_texture(r, c.tex, nullptr, dst);
+        }
+    }
+}
+
+// チャンクを1枚のテクスチャに焼く（タイルが変わったときだけ）
+void NeneTilemap::bake_chunk_(SDL_Renderer* r, int cx, int cy, Chunk& chunk) {
+    chunk.dirty = false;
+    const int col0 = cx * kChunkTiles;
+    const int row0 = cy * kChunkTiles;
+    const int col1 = std::min(col0 + kChunkTiles, cols_);
+    const int row1 = std::min(row0 + kChunkTiles, rows_);
+    bool empty = true;
+    for (int row = row0; row < row1 && empty; ++row) {
+        for (int col = col0; col < col1; ++col) {
+            if (tiles_[static_cast<std::size_t>(row) * cols_ + col] != 0) { empty = false; break; }
+        }
+    }
+    if (empty) {
+        if (chunk.tex) SDL_DestroyTexture(chunk.tex);
+        chunk.tex = nullptr;
+        return;
+    }
+    if (!chunk.tex) {
+        chunk.tex = SDL_CreateTexture(r, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET,
+                                      kChunkTiles * tile_w_, kChunkTiles * tile_h_);
+        if (!chunk.tex) nnthrow(std::string("NeneTilemap: SDL_CreateTexture failed: ") + SDL_GetError());
+        SDL_SetTextureBlendMode(chunk.tex, SDL_BLENDMODE_BLEND);
+    }
+    // 描画先を一時的にチャンクへ切り替える（ビューポートはターゲットごとに別管理）
+    SDL_Texture* prev_target = SDL_GetRenderTarget(r);
+    Uint8 pr = 0, pg = 0, pb = 0, pa = 0;
+    SDL_GetRenderDrawColor(r, &pr, &pg, &pb, &pa);
+    SDL_SetRenderTarget(r, chunk.tex);
+    SDL_SetRenderDrawColor(r, 0, 0, 0, 0);
+    SDL_RenderClear(r);
+    for (int row = row0; row < row1; ++row) {
+        for (int col = col0; col < col1; ++col) {
+            const Tile t = tiles_[static_cast<std::size_t>(row) * cols_ + col];
+            if (t == 0) continue;
+            const int i = t - 1;
+            const SDL_FRect src{ static_cast<float>((i % tileset_cols_) * tile_w_),
+                                 static_cast<float>((i / tileset_cols_) * tile_h_),
+                                 static_cast<float>(tile_w_), static_cast<float>(tile_h_) };
+            const SDL_FRect dst{ static_cast<float>((col - col0) * tile_w_),
+                                 static_cast<float>((row - row0) * tile_h_),
+                                 static_cast<float>(tile_w_), static_cast<float>(tile_h_) };
+            SDL_RenderTexture(r, tileset_, &src, &dst);
+        }
+    }
+    SDL_SetRenderTarget(r, prev_target);
+    SDL_SetRenderDrawColor(r, pr, pg, pb, pa);
+}
+
+// 固体タイルを貪欲法で長方形にまとめてコライダー化（横に伸ばしてから下に伸ばす）
+void NeneTilemap::rebuild_colliders_() {
+    release_colliders_();
+    std::vector<bool> used(tiles_.size(), false);
+    auto solid_at = [&](int col, int row) {
+        const std::size_t i = static_cast<std::size_t>(row) * cols_ + col;
+        return !used[i] && is_solid_(tiles_[i]);
+    };
+    for (int row = 0; row < rows_; ++row) {
+        for (int col = 0; col < cols_; ++col) {
+            if (!solid_at(col, row)) continue;
+            int w = 1;
+            while (col + w < cols_ && solid_at(col + w, row)) ++w;
+            int h = 1;
+            for (bool grow = true; grow && row + h < rows_; ) {
+                for (int k = 0; k < w; ++k) {
+                    if (!solid_at(col + k, row + h)) { grow = false; break; }
+                }
+                if (grow) ++h;
+            }
+            for (int dy = 0; dy < h; ++dy) {
+                for (int dx = 0; dx < w; ++dx) used[static_cast<std::size_t>(row + dy) * cols_ + col + dx] = true;
+            }
+            const float pw = static_cast<float>(w * tile_w_);
+            const float ph = static_cast<float>(h * tile_h_);
+            NeneColorPolygon poly;
+            poly.owner_name = this->name;
+            poly.vertices = {
+                SDL_FPoint{ 0.0f, 0.0f },
+                SDL_FPoint{ pw,   0.0f },
+                SDL_FPoint{ pw,   ph   },
+                SDL_FPoint{ 0.0f, ph   },
+            };
+            poly.position = SDL_FPoint{ origin_.x + static_cast<float>(col * tile_w_),
+                                        origin_.y + static_cast<float>(row * tile_h_) };
+            poly.color = collider_color_;
+            poly.layer = collider_layer_;
+            poly.mask  = collider_mask_;
+            poly.enabled = true;
+            collider_ids_.push_back(collision_world->add_collider(std::move(poly)));
+        }
+    }
+}
+
+void NeneTilemap::release_colliders_() {
+    if (collision_world) {
+        for (auto id : collider_ids_) collision_world->remove_collider(id);
+    }
+    collider_ids_.clear();
+}
+
+// ねねパーティクル
+NeneParticleEmitter::NeneParticleEmitter(std::string name, std::size_t capacity)
+    : NeneNode(std::move(name)), capacity_(capacity) {
+    if (capacity_ == 0) nnthrow("NeneParticleEmitter: capacity is 0");
+    if (capacity_ > static_cast<std::size_t>(std::numeric_limits<int>::max() / 6)) nnthrow("NeneParticleEmitter: capacity too large");
+    for (auto* v : { &x_, &y_, &vx_, &vy_, &t_, &inv_life_ }) v->resize(capacity_);
+    verts_.resize(capacity_ * 4);
+    indices_.resize(capacity_ * 6);
+    for (std::size_t i = 0; i < capacity_; ++i) {
+        const int b = static_cast<int>(i * 4);
+        int* idx = &indices_[i * 6];
+        idx[0] = b; idx[1] = b + 1; idx[2] = b + 2;
+        idx[3] = b; idx[4] = b + 2; idx[5] = b + 3;
+    }
+}
+
+void NeneParticleEmitter::set_texture(SDL_Texture* tex, const SDL_FRect* src) {
+    texture_ = tex;
+    uv_ = SDL_FRect{ 0.0f, 0.0f, 1.0f, 1.0f };
+    if (texture_ && src) {
+        float tw = 0.0f, th = 0.0f;
+        if (!SDL_GetTextureSize(texture_, &tw, &th)) nnthrow("NeneParticleEmitter: SDL_GetTextureSize failed");
+        uv_ = SDL_FRect{ src->x / tw, src->y / th, src->w / tw, src->h / th };
+    }
+}
+
+NeneRng& NeneParticleEmitter::rng_() {
+    if (!rng_ready_ && random) {
+        rng_state_ = random->stream(this->name);
+        rng_ready_ = true;
+    }
+    return rng_state_;
+}
+
+std::size_t NeneParticleEmitter::emit(std::size_t n) {
+    const std::size_t k = std::min(n, capacity_ - size_);
+    if (k == 0) return 0;
+    const Params& p = params_;
+    NeneRng& rng = rng_();
+    const std::size_t b = size_;
+    auto tail = [&](std::vector<float>& v) { return std::span<float>(v.data() + b, k); };
+    // 乱数は配列ごとにまとめて埋める（vx/vy/inv_life には一旦 角度/速さ/寿命 を入れる）
+    rng.fill_uniform(tail(x_), p.position.x - p.spread.x, p.position.x + p.spread.x);
+    rng.fill_uniform(tail(y_), p.position.y - p.spread.y, p.position.y + p.spread.y);
+    rng.fill_uniform(tail(vx_), p.angle_min, p.angle_max);
+    rng.fill_uniform(tail(vy_), p.speed_min, p.speed_max);
+    rng.fill_uniform(tail(inv_life_), p.life_min, p.life_max);
+    for (std::size_t i = b; i < b + k; ++i) {
+        const float a = vx_[i];
+        const float s = vy_[i];
+        vx_[i] = std::cos(a) * s;
+        vy_[i] = std::sin(a) * s;
+        inv_life_[i] = 1.0f / std::max(inv_life_[i], 1e-4f);
+        t_[i] = 0.0f;
+    }
+    size_ += k;
+    return k;
+}
+
+void NeneParticleEmitter::handle_time_lapse(const float& dt) {
+    integrate_(dt);
+    compact_();
+    if (emitting_ && params_.rate > 0.0f) {
+        spawn_acc_ += params_.rate * dt;
+        const float whole = std::floor(spawn_acc_);
+        spawn_acc_ -= whole;
+        emit(static_cast<std::size_t>(whole));
+    }
+}
+
+// 分岐の無い短いループに分けてコンパイラにベクトル化させる
+// （1本にまとめると配列の重なり確認が多すぎてベクトル化されない）
+void NeneParticleEmitter::integrate_(float dt) {
+    const std::size_t n = size_;
+    float* x = x_.data();
+    float* y = y_.data();
+    float* vx = vx_.data();
+    float* vy = vy_.data();
+    float* t = t_.data();
+    const float* inv_life = inv_life_.data();
+    const float gx = params_.gravity.x * dt;
+    const float gy = params_.gravity.y * dt;
+    for (std::size_t i = 0; i < n; ++i) {
+        vx[i] += gx;
+        x[i] += vx[i] * dt;
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+        vy[i] += gy;
+        y[i] += vy[i] * dt;
+    }
+    for (std::size_t i = 0; i < n; ++i) t[i] += inv_life[i] * dt;
+}
+
+// 寿命が尽きた粒を末尾と入れ替えて消す（順番は変わる）
+void NeneParticleEmitter::compact_() {
+    std::size_t i = 0;
+    while (i < size_) {
+        if (t_[i] < 1.0f) { ++i; continue; }
+        const std::size_t last = --size_;
+        x_[i] = x_[last];
+        y_[i] = y_[last];
+        vx_[i] = vx_[last];
+        vy_[i] = vy_[last];
+        t_[i] = t_[last];
+        inv_life_[i] = inv_life_[last];
+    }
+}
+
+void NeneParticleEmitter::render(SDL_Renderer* r) {
+    if (!r || size_ == 0) return;
+    const Params& p = params_;
+    // カメラの変換は頂点を作るときに自分でかける
+    const SDL_FPoint o = camera ? camera->origin() : SDL_FPoint{ 0.0f, 0.0f };
+    const float s = camera ? camera->scale() : 1.0f;
+    const float u0 = uv_.x, v0 = uv_.y;
+    const float u1 = uv_.x + uv_.w, v1 = uv_.y + uv_.h;
+    const SDL_FColor c0 = p.color_start;
+    const SDL_FColor dc{ p.color_end.r - c0.r, p.color_end.g - c0.g, p.color_end.b - c0.b, p.color_end.a - c0.a };
+    const float half0 = 0.5f * p.size_start * s;
+    const float dhalf = 0.5f * (p.size_end - p.size_start) * s;
+    SDL_Vertex* out = verts_.data();
+    for (std::size_t i = 0; i < size_; ++i, out += 4) {
+        const float t = t_[i];
+        const float h = half0 + dhalf * t;
+        const float cx = (x_[i] - o.x) * s;
+        const float cy = (y_[i] - o.y) * s;
+        const SDL_FColor c{ c0.r + dc.r * t, c0.g + dc.g * t, c0.b + dc.b * t, c0.a + dc.a * t };
+        out[0] = SDL_Vertex{ SDL_FPoint{ cx - h, cy - h }, c, SDL_FPoint{ u0, v0 } };
+        out[1] = SDL_Vertex{ SDL_FPoint{ cx + h, cy - h }, c, SDL_FPoint{ u1, v0 } };
+        out[2] = SDL_Vertex{ SDL_FPoint{ cx + h, cy + h }, c, SDL_FPoint{ u1, v1 } };
+        out[3] = SDL_Vertex{ SDL_FPoint{ cx - h, cy + h }, c, SDL_FPoint{ u0, v1 } };
+    }
+    SDL_RenderGeometry(r, texture_, verts_.data(), static_cast<int>(size_ * 4),
+                       indices_.data(), static_cast<int>(size_ * 6));
+}
+
+// ねねエンティティホスト
+void NeneEntityHost::add_system(std::string name, System fn) {
+    if (!fn) nnthrow("add_system: fn is null");
+    request_(Change{ std::move(name), std::move(fn), {} });
+}
+
+void NeneEntityHost::add_render_system(std::string name, RenderSystem fn) {
+    if (!fn) nnthrow("add_render_system: fn is null");
+    request_(Change{ std::move(name), {}, std::move(fn) });
+}
+
+bool NeneEntityHost::remove_system(std::string_view name) {
+    bool found = false;
+    for (const auto& s : systems_) found = found || s.name == name;
+    for (const auto& s : render_systems_) found = found || s.name == name;
+    for (const auto& c : pending_) {
+        if (c.name == name) found = (c.fn || c.render_fn);
+    }
+    if (found) request_(Change{ std::string(name), {}, {} });
+    return found;
+}
+
+// 回している最中は std::function を動かしたり壊したりしないように, 変更を積んでおく
+void NeneEntityHost::request_(Change c) {
+    if (running_) pending_.push_back(std::move(c));
+    else apply_(std::move(c));
+}
+
+void NeneEntityHost::apply_(Change c) {
+    auto upsert = [&](auto& list, auto&& fn) {
+        for (auto& e : list) {
+            if (e.name == c.name) { e.fn = std::move(fn); return; }
+        }
+        list.push_back({ c.name, std::move(fn) });
+    };
+    auto erase = [&](auto& list) {
+        list.erase(std::remove_if(list.begin(), list.end(), [&](const auto& e) { return e.name == c.name; }), list.end());
+    };
+    if (c.fn) {
+        upsert(systems_, std::move(c.fn));
+    } else if (c.render_fn) {
+        upsert(render_systems_, std::move(c.render_fn));
+    } else {
+        erase(systems_);
+        erase(render_systems_);
+    }
+}
+
+void NeneEntityHost::apply_pending_() {
+    std::vector<Change> changes;
+    changes.swap(pending_);
+    for (auto& c : changes) apply_(std::move(c));
+}
+
+void NeneEntityHost::handle_time_lapse(const float& dt) {
+    {
+        running_ = true;
+        struct Guard {
+            NeneEntityHost* self;
+            ~Guard() { self->running_ = false; }
+        } guard{this};
+        for (auto& s : systems_) {
+            s.fn(registry_, dt);
+            registry_.flush(); // destroy_later された物体は次のシステムに見せない
+        }
+    }
+    apply_pending_();
+}
+
+void NeneEntityHost::render(SDL_Renderer* r) {
+    if (!r) return;
+    {
+        running_ = true;
+        struct Guard {
+            NeneEntityHost* self;
+            ~Guard() { self->running_ = false; }
+        } guard{this};
+        for (auto& s : render_systems_) s.fn(registry_, r, camera.get());
+    }
+    apply_pending_();
+}
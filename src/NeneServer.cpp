@@ -1,6 +1,9 @@
 #include <SDL3/SDL.h>
 #include <SDL3_ttf/SDL_ttf.h>
+#include <algorithm>
+#include <cstring>
 #include <NeneEngine/NeneServer.hpp>
+#include <NeneEngine/NeneUtilities.hpp>
 
 NeneFontLoader::NeneFontLoader(SDL_Renderer* renderer)
     : renderer_(renderer) {
@@ -13,44 +16,55 @@ NeneFontLoader::NeneFontLoader(SDL_Renderer* renderer)
 }
 
 NeneFontLoader::~NeneFontLoader() {
-    for (auto& [key, font] : fontCache_) {
+    glyphAtlases_.clear();
+
+    for (TTF_Font* font : fonts_) {
         if (font) TTF_CloseFont(font);
     }
-    fontCache_.clear();
+    fonts_.clear();
+    fontIds_.clear();
 
-    for (auto& [fontKey, tex] : textCache_) {
-        if (tex) SDL_DestroyTexture(tex);
-    }
     textCache_.clear();
 
     TTF_Quit();
 }
 
-TTF_Font* NeneFontLoader::get_font(const std::string& fontPath, int fontSize) {
+NeneFontId NeneFontLoader::font_id(const std::string& fontPath, int fontSize) {
     std::string key = fontPath + "#" + std::to_string(fontSize);
-    auto it = fontCache_.find(key);
-    if (it != fontCache_.end()) return it->second;
+    auto it = fontIds_.find(key);
+    if (it != fontIds_.end()) return it->second;
+    nene_require_serial("NeneFontLoader::font_id");
 
     TTF_Font* font = TTF_OpenFont(fontPath.c_str(), fontSize);
     if (!font) {
         throw std::runtime_error(std::string("TTF_OpenFont failed: ") + SDL_GetError());
     }
-    fontCache_[key] = font;
-    return font;
+    const NeneFontId id = static_cast<NeneFontId>(fonts_.size());
+    fonts_.push_back(font);
+    fontIds_.emplace(std::move(key), id);
+    return id;
 }
 
 SDL_Texture* NeneFontLoader::get_text_texture(const std::string& fontPath, int fontSize,
                                          const std::string& text, SDL_Color color) {
-    FontKey fk{ text, fontSize, color };
-    auto it = textCache_.find(fk);
-    if (it != textCache_.end()) return it->second;
+    nene_require_serial("NeneFontLoader::get_text_texture");
+    NeneTextureHandle slot = acquire_text(fontPath, fontSize, text, color);
+    slot->pinned = true;
+    return slot->texture;
+}
+
+NeneTextureHandle NeneFontLoader::acquire_text(NeneFontId font_id, const std::string& text, SDL_Color color) {
+    nene_require_serial("NeneFontLoader::acquire_text");
+    FontKey fk{ font_id, text, color };
+    if (auto hit = textCache_.find(fk)) return hit;
 
-    TTF_Font* font = get_font(fontPath, fontSize);
+    TTF_Font* font = this->font(font_id);
 
     SDL_Surface* surf = TTF_RenderText_Blended(font, text.c_str(), 0, color);
     if (!surf) {
         throw std::runtime_error(std::string("TTF_RenderText_Blended failed: ") + SDL_GetError());
     }
+    const std::size_t bytes = static_cast<std::size_t>(surf->w) * static_cast<std::size_t>(surf->h) * 4u;
 
     SDL_Texture* tex = SDL_CreateTextureFromSurface(renderer_, surf);
     SDL_DestroySurface(surf);
@@ -59,6 +73,1220 @@ SDL_Texture* NeneFontLoader::get_text_texture(const std::string& fontPath, int f
         throw std::runtime_error(std::string("SDL_CreateTextureFromSurface failed: ") + SDL_GetError());
     }
 
-    textCache_[fk] = tex;
-    return tex;
+    auto slot = std::make_shared<NeneTextureSlot>();
+    slot->path = text;
+    slot->texture = tex;
+    slot->bytes = bytes;
+    slot->state = NeneAssetState::Ready;
+    textCache_.insert(fk, slot);
+    textCache_.trim();
+    return slot;
+}
+
+NeneTextHandle NeneFontLoader::make_text(NeneFontId font_id, SDL_Color color, std::string_view text) {
+    nene_require_serial("NeneFontLoader::make_text");
+    NeneTextHandle h(renderer_, font(font_id), color);
+    h.set_text(text);
+    return h;
+}
+
+NeneGlyphAtlas* NeneFontLoader::glyph_atlas(NeneFontId font_id) {
+    nene_require_serial("NeneFontLoader::glyph_atlas");
+    TTF_Font* f = font(font_id);
+    if (glyphAtlases_.size() <= font_id) glyphAtlases_.resize(static_cast<std::size_t>(font_id) + 1);
+    auto& atlas = glyphAtlases_[font_id];
+    if (!atlas) atlas = std::make_unique<NeneGlyphAtlas>(renderer_, f);
+    return atlas.get();
+}
+
+// NeneTextHandle
+NeneTextHandle::NeneTextHandle(SDL_Renderer* renderer, TTF_Font* font, SDL_Color color)
+    : renderer_(renderer), font_(font), color_(color) {
+    if (!renderer_ || !font_) {
+        throw std::runtime_error("NeneTextHandle: renderer or font is null");
+    }
+}
+
+NeneTextHandle::~NeneTextHandle() {
+    release_();
+}
+
+NeneTextHandle::NeneTextHandle(NeneTextHandle&& o) noexcept
+    : renderer_(o.renderer_), font_(o.font_), color_(o.color_), text_(std::move(o.text_)),
+      tex_(o.tex_), cap_w_(o.cap_w_), cap_h_(o.cap_h_), src_(o.src_) {
+    o.tex_ = nullptr;
+    o.cap_w_ = o.cap_h_ = 0;
+}
+
+NeneTextHandle& NeneTextHandle::operator=(NeneTextHandle&& o) noexcept {
+    if (this == &o) return *this;
+    release_();
+    renderer_ = o.renderer_;
+    font_ = o.font_;
+    color_ = o.color_;
+    text_ = std::move(o.text_);
+    tex_ = o.tex_;
+    cap_w_ = o.cap_w_;
+    cap_h_ = o.cap_h_;
+    src_ = o.src_;
+    o.tex_ = nullptr;
+    o.cap_w_ = o.cap_h_ = 0;
+    return *this;
+}
+
+void NeneTextHandle::release_() {
+    if (tex_) SDL_DestroyTexture(tex_);
+    tex_ = nullptr;
+    cap_w_ = cap_h_ = 0;
+}
+
+void NeneTextHandle::set_text(std::string_view text) {
+    if (tex_ && text_ == text) return; // 変わっていなければ何もしない
+    text_.assign(text.data(), text.size());
+    rerender_();
+}
+
+void NeneTextHandle::set_color(SDL_Color color) {
+    if (color.r == color_.r && color.g == color_.g && color.b == color_.b && color.a == color_.a) return;
+    color_ = color;
+    rerender_();
+}
+
+void NeneTextHandle::rerender_() {
+    src_ = SDL_FRect{ 0.0f, 0.0f, 0.0f, 0.0f };
+    if (!font_ || text_.empty()) return;
+    SDL_Surface* raw = TTF_RenderText_Blended(font_, text_.data(), text_.size(), color_);
+    if (!raw) {
+        throw std::runtime_error(std::string("TTF_RenderText_Blended failed: ") + SDL_GetError());
+    }
+    SDL_Surface* surf = SDL_ConvertSurface(raw, SDL_PIXELFORMAT_RGBA32);
+    SDL_DestroySurface(raw);
+    if (!surf) {
+        throw std::runtime_error(std::string("SDL_ConvertSurface failed: ") + SDL_GetError());
+    }
+    // 収まらないときだけ作り直す（幅は少し余裕を持たせる）
+    if (!tex_ || surf->w > cap_w_ || surf->h > cap_h_) {
+        release_();
+        cap_w_ = (surf->w + 63) & ~63;
+        cap_h_ = surf->h;
+        tex_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, cap_w_, cap_h_);
+        if (!tex_) {
+            SDL_DestroySurface(surf);
+            cap_w_ = cap_h_ = 0;
+            throw std::runtime_error(std::string("SDL_CreateTexture failed: ") + SDL_GetError());
+        }
+        SDL_SetTextureBlendMode(tex_, SDL_BLENDMODE_BLEND);
+        SDL_SetTextureScaleMode(tex_, SDL_SCALEMODE_NEAREST); // 使っていない領域を拾わない
+    }
+    const SDL_Rect rect{ 0, 0, surf->w, surf->h };
+    SDL_UpdateTexture(tex_, &rect, surf->pixels, surf->pitch);
+    src_ = SDL_FRect{ 0.0f, 0.0f, static_cast<float>(surf->w), static_cast<float>(surf->h) };
+    SDL_DestroySurface(surf);
+}
+
+// NeneGlyphAtlas
+NeneGlyphAtlas::NeneGlyphAtlas(SDL_Renderer* renderer, TTF_Font* font, int page_size)
+    : renderer_(renderer), font_(font), page_size_(page_size) {
+    if (!renderer_ || !font_) {
+        throw std::runtime_error("NeneGlyphAtlas: renderer or font is null");
+    }
+    line_h_ = TTF_GetFontHeight(font_);
+}
+
+NeneGlyphAtlas::~NeneGlyphAtlas() {
+    for (SDL_Texture* page : pages_) {
+        if (page) SDL_DestroyTexture(page);
+    }
+    pages_.clear();
+}
+
+const NeneGlyphAtlas::Glyph& NeneGlyphAtlas::glyph_(std::uint32_t cp) {
+    if (cp < 128) {
+        if (!ascii_ready_[cp]) {
+            ascii_[cp] = rasterize_(cp);
+            ascii_ready_[cp] = true;
+        }
+        return ascii_[cp];
+    }
+    auto it = others_.find(cp);
+    if (it != others_.end()) return it->second;
+    return others_.emplace(cp, rasterize_(cp)).first->second;
+}
+
+// 白でラスタライズしてページに詰める（色は頂点カラーで付ける）
+// 並列パルスの中の measure は詰め済みのグリフだけ（新しい文字は throw）
+NeneGlyphAtlas::Glyph NeneGlyphAtlas::rasterize_(std::uint32_t cp) {
+    nene_require_serial("NeneGlyphAtlas: new glyph");
+    Glyph g;
+    int advance = 0;
+    if (TTF_GetGlyphMetrics(font_, cp, nullptr, nullptr, nullptr, nullptr, &advance)) {
+        g.advance = static_cast<float>(advance);
+    }
+    if (cp == ' ' || cp == '\t' || cp == '\n') return g;
+    SDL_Surface* raw = TTF_RenderGlyph_Blended(font_, cp, SDL_Color{ 255, 255, 255, 255 });
+    if (!raw) return g; // フォントに無い文字は送りだけ
+    SDL_Surface* surf = SDL_ConvertSurface(raw, SDL_PIXELFORMAT_RGBA32);
+    SDL_DestroySurface(raw);
+    if (!surf) {
+        throw std::runtime_error(std::string("NeneGlyphAtlas: SDL_ConvertSurface failed: ") + SDL_GetError());
+    }
+    constexpr int kPad = 1;
+    const int w = surf->w;
+    const int h = surf->h;
+    if (w + kPad > page_size_ || h + kPad > page_size_) {
+        SDL_DestroySurface(surf);
+        return g;
+    }
+    // 棚詰め（入らなければ次の棚, 次のページ）
+    if (pen_x_ + w + kPad > page_size_) {
+        pen_x_ = 0;
+        pen_y_ += shelf_h_;
+        shelf_h_ = 0;
+    }
+    if (pages_.empty() || pen_y_ + h + kPad > page_size_) {
+        SDL_Texture* page = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC,
+                                              page_size_, page_size_);
+        if (!page) {
+            SDL_DestroySurface(surf);
+            throw std::runtime_error(std::string("NeneGlyphAtlas: SDL_CreateTexture failed: ") + SDL_GetError());
+        }
+        // 余白が透明になるように一度だけ0で埋める
+        std::vector<std::uint32_t> zero(static_cast<std::size_t>(page_size_) * page_size_, 0u);
+        SDL_UpdateTexture(page, nullptr, zero.data(), page_size_ * 4);
+        SDL_SetTextureBlendMode(page, SDL_BLENDMODE_BLEND);
+        pages_.push_back(page);
+        verts_.emplace_back();
+        indices_.emplace_back();
+        pen_x_ = 0;
+        pen_y_ = 0;
+        shelf_h_ = 0;
+    }
+    const SDL_Rect dst{ pen_x_, pen_y_, w, h };
+    SDL_UpdateTexture(pages_.back(), &dst, surf->pixels, surf->pitch);
+    SDL_DestroySurface(surf);
+    g.src = SDL_FRect{ static_cast<float>(pen_x_), static_cast<float>(pen_y_),
+                       static_cast<float>(w), static_cast<float>(h) };
+    g.page = static_cast<int>(pages_.size()) - 1;
+    pen_x_ += w + kPad;
+    if (h + kPad > shelf_h_) shelf_h_ = h + kPad;
+    return g;
+}
+
+float NeneGlyphAtlas::kerning_(std::uint32_t prev, std::uint32_t cp) const {
+    int k = 0;
+    if (prev == 0 || !TTF_GetGlyphKerning(font_, prev, cp, &k)) return 0.0f;
+    return static_cast<float>(k);
+}
+
+SDL_FPoint NeneGlyphAtlas::measure(std::string_view text) {
+    float x = 0.0f;
+    std::uint32_t prev = 0;
+    for (std::size_t i = 0; i < text.size(); ) {
+        const std::uint32_t cp = nene_utf8_next(text, i);
+        x += kerning_(prev, cp) + glyph_(cp).advance;
+        prev = cp;
+    }
+    return SDL_FPoint{ x, static_cast<float>(line_h_) };
+}
+
+void NeneGlyphAtlas::draw(std::string_view text, float x, float y, SDL_Color color) {
+    const SDL_FColor col{ color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f };
+    for (auto& v : verts_) v.clear();
+    for (auto& v : indices_) v.clear();
+    const float inv = 1.0f / static_cast<float>(page_size_);
+    float pen = x;
+    std::uint32_t prev = 0;
+    for (std::size_t i = 0; i < text.size(); ) {
+        const std::uint32_t cp = nene_utf8_next(text, i);
+        pen += kerning_(prev, cp);
+        prev = cp;
+        const Glyph& g = glyph_(cp); // ここでページが増えることもある
+        if (g.page >= 0) {
+            auto& vs = verts_[static_cast<std::size_t>(g.page)];
+            auto& is = indices_[static_cast<std::size_t>(g.page)];
+            const int base = static_cast<int>(vs.size());
+            const float u0 = g.src.x * inv, v0 = g.src.y * inv;
+            const float u1 = (g.src.x + g.src.w) * inv, v1 = (g.src.y + g.src.h) * inv;
+            vs.push_back(SDL_Vertex{ SDL_FPoint{ pen,           y            }, col, SDL_FPoint{ u0, v0 } });
+            vs.push_back(SDL_Vertex{ SDL_FPoint{ pen + g.src.w, y            }, col, SDL_FPoint{ u1, v0 } });
+            vs.push_back(SDL_Vertex{ SDL_FPoint{ pen + g.src.w, y + g.src.h  }, col, SDL_FPoint{ u1, v1 } });
+            vs.push_back(SDL_Vertex{ SDL_FPoint{ pen,           y + g.src.h  }, col, SDL_FPoint{ u0, v1 } });
+            is.insert(is.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+        }
+        pen += g.advance;
+    }
+    for (std::size_t p = 0; p < pages_.size(); ++p) {
+        if (indices_[p].empty()) continue;
+        SDL_RenderGeometry(renderer_, pages_[p], verts_[p].data(), static_cast<int>(verts_[p].size()),
+                           indices_[p].data(), static_cast<int>(indices_[p].size()));
+    }
+}
+
+// NeneBlackboard
+template <class T>
+void NeneBlackboard::flush_slots_(Slots<T>& s, NeneMailServer& mail) {
+    for (std::uint32_t idx : s.flushing) {
+        // 呼び出し中に購読が増えても大丈夫なように添字で回す
+        const std::size_t n = s.subs[idx].size();
+        for (std::size_t i = 0; i < n; ++i) {
+            Sub<T>& sub = s.subs[idx][i];
+            if (sub.id == 0) continue; // 解除済み
+            if (sub.fn) {
+                auto fn = sub.fn; // 呼び出し中に vector が伸びても安全なように写す
+                fn(s.values[idx]);
+            } else {
+                mail.push(NeneMail(sub.mail_to, "blackboard", sub.mail_subject, s.names[idx]));
+            }
+        }
+    }
+    s.flushing.clear();
+}
+
+void NeneBlackboard::flush(NeneMailServer& mail) {
+    nene_require_serial("NeneBlackboard::flush");
+    // 先に全部の変更リストを取り出す（購読者の中の書き込みは次の flush へ）
+    std::apply([](auto&... s) {
+        ((s.flushing.swap(s.dirty_list),
+          [&s] { for (std::uint32_t idx : s.flushing) s.dirty[idx] = 0; }()), ...);
+    }, slots_data_);
+    flushing_ = true;
+    std::apply([&](auto&... s) { (flush_slots_(s, mail), ...); }, slots_data_);
+    flushing_ = false;
+    // 解除済みの購読を詰める
+    std::apply([](auto&... s) {
+        ([&s] {
+            for (auto& list : s.subs) {
+                list.erase(std::remove_if(list.begin(), list.end(),
+                                          [](const auto& sub) { return sub.id == 0; }),
+                           list.end());
+            }
+        }(), ...);
+    }, slots_data_);
+}
+
+std::uint64_t NeneBlackboard::next_serial_() {
+    static std::atomic<std::uint64_t> serial{ 1 };
+    return serial.fetch_add(1, std::memory_order_relaxed);
+}
+
+namespace {
+thread_local std::uint32_t t_writer_rank = 0;
+}
+
+void NeneBlackboard::set_writer_rank(std::uint32_t rank) {
+    t_writer_rank = rank;
+}
+
+std::uint32_t NeneBlackboard::writer_rank() {
+    return t_writer_rank;
+}
+
+NeneBlackboard::Stage& NeneBlackboard::this_thread_stage_() {
+    // 同じ黒板が続く間はロックを取らない
+    struct Cache {
+        std::uint64_t serial = 0;
+        Stage* stage = nullptr;
+    };
+    thread_local Cache cache;
+    if (cache.serial == serial_) return *cache.stage;
+    std::lock_guard<std::mutex> lock(stage_mutex_);
+    auto& st = stages_[std::this_thread::get_id()];
+    if (!st) st = std::make_unique<Stage>();
+    cache.serial = serial_;
+    cache.stage = st.get();
+    return *st;
+}
+
+void NeneBlackboard::set_double_buffered(bool on) {
+    nene_require_serial("NeneBlackboard::set_double_buffered");
+    if (double_buffered_ == on) return;
+    if (!on) commit(); // 積み残しを確定してから戻す
+    double_buffered_ = on;
+}
+
+template <class T>
+void NeneBlackboard::commit_slots_(Slots<T>& s, StagedList<T>& merged) {
+    if (merged.empty()) return;
+    // スロット順 → set を先 → set は順位の低い順 / add は値の小さい順
+    std::sort(merged.begin(), merged.end(), [](const Staged<T>& a, const Staged<T>& b) {
+        if (a.index != b.index) return a.index < b.index;
+        if (a.add != b.add) return !a.add;
+        if (!a.add && a.rank != b.rank) return a.rank < b.rank;
+        return less_(a.value, b.value);
+    });
+    std::size_t i = 0;
+    while (i < merged.size()) {
+        const std::uint32_t idx = merged[i].index;
+        T value = s.values[idx];
+        for (; i < merged.size() && merged[i].index == idx; ++i) {
+            if (!merged[i].add) {
+                value = std::move(merged[i].value); // 後ろほど順位が高い
+            } else {
+                if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>) value += merged[i].value;
+            }
+        }
+        if (same_(s.values[idx], value)) continue;
+        s.values[idx] = std::move(value);
+        ++s.versions[idx];
+        mark_dirty_(s, idx);
+    }
+    merged.clear();
+}
+
+void NeneBlackboard::commit() {
+    nene_require_serial("NeneBlackboard::commit");
+    // 下書きを1本にまとめる（スレッドの並び順には依存しない. 順番は commit_slots_ の並べ替えで決まる）
+    auto gather = [](auto& dst, auto& src) {
+        dst.insert(dst.end(), std::make_move_iterator(src.begin()), std::make_move_iterator(src.end()));
+        src.clear();
+    };
+    {
+        std::lock_guard<std::mutex> lock(stage_mutex_);
+        for (auto& [tid, st] : stages_) {
+            gather(std::get<StagedList<float>>(merged_.ops), std::get<StagedList<float>>(st->ops));
+            gather(std::get<StagedList<int>>(merged_.ops), std::get<StagedList<int>>(st->ops));
+            gather(std::get<StagedList<bool>>(merged_.ops), std::get<StagedList<bool>>(st->ops));
+            gather(std::get<StagedList<SDL_FPoint>>(merged_.ops), std::get<StagedList<SDL_FPoint>>(st->ops));
+            gather(std::get<StagedList<std::string>>(merged_.ops), std::get<StagedList<std::string>>(st->ops));
+        }
+    }
+    commit_slots_(slots_<float>(), std::get<StagedList<float>>(merged_.ops));
+    commit_slots_(slots_<int>(), std::get<StagedList<int>>(merged_.ops));
+    commit_slots_(slots_<bool>(), std::get<StagedList<bool>>(merged_.ops));
+    commit_slots_(slots_<SDL_FPoint>(), std::get<StagedList<SDL_FPoint>>(merged_.ops));
+    commit_slots_(slots_<std::string>(), std::get<StagedList<std::string>>(merged_.ops));
+}
+
+void NeneBlackboard::unsubscribe_(std::uint8_t kind, std::uint32_t index, std::uint64_t id) {
+    auto drop = [&](auto& s) {
+        auto& list = s.subs[index];
+        for (auto& sub : list) {
+            if (sub.id != id) continue;
+            sub.id = 0;
+            sub.fn = nullptr;
+            break;
+        }
+        // flush 中でなければすぐ詰める
+        if (!flushing_) {
+            list.erase(std::remove_if(list.begin(), list.end(),
+                                      [](const auto& sub) { return sub.id == 0; }),
+                       list.end());
+        }
+    };
+    switch (kind) {
+        case kind_v<float>:       drop(slots_<float>()); break;
+        case kind_v<int>:         drop(slots_<int>()); break;
+        case kind_v<bool>:        drop(slots_<bool>()); break;
+        case kind_v<SDL_FPoint>:  drop(slots_<SDL_FPoint>()); break;
+        case kind_v<std::string>: drop(slots_<std::string>()); break;
+        default: break;
+    }
+}
+
+// NeneWorkerPool
+NeneWorkerPool::NeneWorkerPool(unsigned worker_count) {
+    if (worker_count == 0) {
+        const unsigned hc = std::thread::hardware_concurrency();
+        worker_count = (hc > 1) ? hc - 1 : 0;
+    }
+    worker_count_ = worker_count;
+}
+
+// call_mutex_ を持った状態で呼ぶ
+void NeneWorkerPool::start_workers_() {
+    queues_.reserve(worker_count_ + 1);
+    for (unsigned i = 0; i <= worker_count_; ++i) queues_.push_back(std::make_unique<Queue>());
+    workers_.reserve(worker_count_);
+    for (unsigned i = 0; i < worker_count_; ++i) {
+        workers_.emplace_back([this, i] { worker_main_(i + 1); });
+    }
+}
+
+NeneWorkerPool::~NeneWorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& t : workers_) {
+        if (t.joinable()) t.join();
+    }
+}
+
+namespace {
+thread_local bool t_in_parallel_task = false;
+// タスクを回している間だけ立てる（例外で抜けても戻す）
+struct ParallelTaskScope {
+    ParallelTaskScope() { t_in_parallel_task = true; }
+    ~ParallelTaskScope() { t_in_parallel_task = false; }
+};
+}
+
+bool nene_in_parallel_task() {
+    return t_in_parallel_task;
+}
+
+void NeneWorkerPool::parallel_for(std::size_t n, const std::function<void(std::size_t)>& fn) {
+    if (n == 0) return;
+    // 1つだけ, またはワーカーがいないならその場で回す（見張りは並列のときと同じにする）
+    if (n == 1 || worker_count_ == 0) {
+        for (std::size_t i = 0; i < n; ++i) {
+            ParallelTaskScope scope;
+            fn(i);
+        }
+        return;
+    }
+    std::lock_guard<std::mutex> call(call_mutex_);
+    if (workers_.empty()) start_workers_();
+    Job job;
+    job.fn = &fn;
+    job.remaining.store(n, std::memory_order_relaxed);
+    // 各キューに順番に配る（偏ったら盗み合う）
+    const std::size_t qn = queues_.size();
+    for (std::size_t q = 0; q < qn; ++q) {
+        std::lock_guard<std::mutex> lock(queues_[q]->mutex);
+        for (std::size_t i = q; i < n; i += qn) queues_[q]->tasks.push_back(Task{ &job, i });
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++job_seq_;
+    }
+    cv_.notify_all();
+    while (job.remaining.load(std::memory_order_acquire) > 0) {
+        if (!run_one_(0)) std::this_thread::yield();
+    }
+    if (job.error) std::rethrow_exception(job.error);
+}
+
+bool NeneWorkerPool::run_one_(std::size_t self) {
+    Task task{ nullptr, 0 };
+    {
+        Queue& own = *queues_[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+        }
+    }
+    for (std::size_t k = 1; !task.job && k < queues_.size(); ++k) {
+        Queue& victim = *queues_[(self + k) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+        }
+    }
+    if (!task.job) return false;
+    try {
+        ParallelTaskScope scope;
+        (*task.job->fn)(task.index);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(task.job->error_mutex);
+        if (!task.job->error) task.job->error = std::current_exception();
+    }
+    // これ以降 job には触らない（呼び出し側が待ち終えて破棄する）
+    task.job->remaining.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+void NeneWorkerPool::worker_main_(std::size_t self) {
+    std::uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [&] { return stop_ || job_seq_ != seen; });
+            if (stop_) return;
+            seen = job_seq_;
+        }
+        while (run_one_(self)) {}
+    }
+}
+
+// NeneAnimationSystem
+NeneAnimId NeneAnimationSystem::add(NeneAnimClipId clip, const std::string& notify_to, const void* owner) {
+    nene_require_serial("NeneAnimationSystem::add");
+    const NeneAnimId id = static_cast<NeneAnimId>(sparse_.size());
+    const std::uint32_t i = static_cast<std::uint32_t>(ids_.size());
+    sparse_.push_back(i);
+    ids_.push_back(id);
+    clip_.push_back(kNeneNoClip);
+    first_.push_back(0);
+    count_.push_back(0);
+    idx_.push_back(0);
+    t_.push_back(0.0f);
+    dur_.push_back(std::numeric_limits<float>::infinity());
+    speed_.push_back(1.0f);
+    finished_.push_back(0);
+    notify_.push_back(notify_to);
+    owner_.push_back(owner);
+    if (owner) ++owned_[owner];
+    if (clip != kNeneNoClip) start_(i, clip);
+    return id;
+}
+
+void NeneAnimationSystem::remove(NeneAnimId id) {
+    nene_require_serial("NeneAnimationSystem::remove");
+    const std::uint32_t i = dense_of_(id);
+    if (i == kNone) return;
+    if (const void* owner = owner_[i]) {
+        auto it = owned_.find(owner);
+        if (--it->second == 0) owned_.erase(it);
+    }
+    const std::uint32_t last = static_cast<std::uint32_t>(ids_.size() - 1);
+    if (i != last) {
+        ids_[i] = ids_[last];
+        clip_[i] = clip_[last];
+        first_[i] = first_[last];
+        count_[i] = count_[last];
+        idx_[i] = idx_[last];
+        t_[i] = t_[last];
+        dur_[i] = dur_[last];
+        speed_[i] = speed_[last];
+        finished_[i] = finished_[last];
+        notify_[i] = std::move(notify_[last]);
+        owner_[i] = owner_[last];
+        sparse_[ids_[i]] = i;
+    }
+    ids_.pop_back();
+    clip_.pop_back();
+    first_.pop_back();
+    count_.pop_back();
+    idx_.pop_back();
+    t_.pop_back();
+    dur_.pop_back();
+    speed_.pop_back();
+    finished_.pop_back();
+    notify_.pop_back();
+    owner_.pop_back();
+    sparse_[id] = kNone;
+}
+
+std::size_t NeneAnimationSystem::remove_owner(const void* owner) {
+    nene_require_serial("NeneAnimationSystem::remove_owner");
+    if (!owner) return 0;
+    auto it = owned_.find(owner);
+    if (it == owned_.end()) return 0;
+    const std::size_t n = it->second;
+    // 末尾と入れ替えて消すので後ろから見る
+    for (std::size_t i = ids_.size(); i-- > 0;) {
+        if (owner_[i] == owner) remove(ids_[i]);
+    }
+    return n;
+}
+
+void NeneAnimationSystem::play(NeneAnimId id, NeneAnimClipId clip, bool restart) {
+    const std::uint32_t i = dense_of_(id);
+    if (i == kNone) return;
+    if (!restart && clip_[i] == clip) return;
+    start_(i, clip);
+}
+
+void NeneAnimationSystem::start_(std::uint32_t i, NeneAnimClipId clip) {
+    clip_[i] = clip;
+    idx_[i] = 0;
+    t_[i] = 0.0f;
+    finished_[i] = 0;
+    if (clip == kNeneNoClip || clip >= clips_.clip_count()) {
+        clip_[i] = kNeneNoClip;
+        first_[i] = 0;
+        count_[i] = 0;
+        dur_[i] = std::numeric_limits<float>::infinity();
+        return;
+    }
+    const NeneAnimClipLibrary::ClipInfo& info = clips_.info(clip);
+    first_[i] = info.first;
+    count_[i] = info.count;
+    dur_[i] = info.count ? clips_.frame_duration(info.first) : std::numeric_limits<float>::infinity();
+}
+
+void NeneAnimationSystem::advance_(std::uint32_t i) {
+    const NeneAnimClipLibrary::ClipInfo& info = clips_.info(clip_[i]);
+    // ループ中で何周も進んだときは余りだけ見る
+    if (info.loop && t_[i] >= info.total) t_[i] = std::fmod(t_[i], info.total);
+    while (t_[i] >= dur_[i]) {
+        t_[i] -= dur_[i];
+        if (++idx_[i] == count_[i]) {
+            if (info.loop) {
+                idx_[i] = 0;
+            } else {
+                // 最後のフレームで止める
+                idx_[i] = count_[i] - 1;
+                t_[i] = 0.0f;
+                dur_[i] = std::numeric_limits<float>::infinity();
+                finished_[i] = 1;
+                events_.push_back(NeneAnimFinished{ ids_[i], clip_[i] });
+                if (info.next != kNeneNoClip) start_(i, info.next);
+                return;
+            }
+        }
+        dur_[i] = clips_.frame_duration(first_[i] + idx_[i]);
+    }
+}
+
+void NeneAnimationSystem::update(float dt, NeneMailServer& mail_server, OwnerPaused paused) {
+    nene_require_serial("NeneAnimationSystem::update");
+    events_.clear();
+    if (paused_) return;
+    const std::size_t n = ids_.size();
+    // まとめて時間を進める
+    float* t = t_.data();
+    const float* speed = speed_.data();
+    if (paused && !owned_.empty()) {
+        // 持ち主が止まっているものは進めない（判定は先に済ませて, 進める方は分岐なしのまま）
+        gate_.resize(n);
+        for (std::size_t i = 0; i < n; ++i) gate_[i] = (owner_[i] && paused(owner_[i])) ? 0.0f : 1.0f;
+        const float* gate = gate_.data();
+        for (std::size_t i = 0; i < n; ++i) t[i] += dt * speed[i] * gate[i];
+    } else {
+        for (std::size_t i = 0; i < n; ++i) t[i] += dt * speed[i];
+    }
+    // フレームの切り替わりがあるものだけ拾う（分岐なしで詰める）
+    due_.resize(n);
+    const float* dur = dur_.data();
+    std::size_t m = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        due_[m] = static_cast<std::uint32_t>(i);
+        m += (t[i] >= dur[i]) ? 1u : 0u;
+    }
+    for (std::size_t k = 0; k < m; ++k) advance_(due_[k]);
+    // 終了通知はまとめて送る
+    for (const NeneAnimFinished& ev : events_) {
+        const std::uint32_t i = dense_of_(ev.id);
+        if (notify_[i].empty()) continue;
+        mail_server.push(NeneMail(notify_[i], "animation", "anim_finished", clips_.name(ev.clip)));
+    }
+}
+
+// NeneInput
+NeneActionId NeneInput::action(const std::string& name, const std::string& default_keys) {
+    auto it = ids_.find(name);
+    if (it != ids_.end()) return it->second;
+    if (names_.size() >= kMaxActions) {
+        throw std::runtime_error("NeneInput: too many actions (max 64)");
+    }
+    if (!blackboard_) throw std::runtime_error("NeneInput: blackboard is null");
+    const NeneActionId id = static_cast<NeneActionId>(names_.size());
+    ids_.emplace(name, id);
+    names_.push_back(name);
+    bound_.emplace_back();
+    const NeneBBKey<std::string> key = blackboard_->key<std::string>("input." + name);
+    keys_.push_back(key);
+    if (blackboard_->get(key).empty() && !default_keys.empty()) blackboard_->set(key, default_keys);
+    // 登録時に1回, 以降は書き換えのたびに表を作り直す
+    subs_.push_back(blackboard_->subscribe<std::string>(key,
+        [this, id](const std::string& keys) { compile_(id, keys); }));
+    return id;
+}
+
+void NeneInput::bind(NeneActionId id, const std::string& keys) {
+    if (id >= keys_.size()) throw std::runtime_error("NeneInput: unknown action");
+    blackboard_->set(keys_[id], keys);
+}
+
+void NeneInput::compile_(NeneActionId id, const std::string& keys) {
+    const NeneActionMask bit = NeneActionMask{ 1 } << id;
+    for (SDL_Scancode sc : bound_[id]) table_[sc] &= ~bit;
+    bound_[id].clear();
+    std::size_t pos = 0;
+    while (pos <= keys.size()) {
+        std::size_t end = keys.find(',', pos);
+        if (end == std::string::npos) end = keys.size();
+        std::size_t b = pos, e = end;
+        while (b < e && keys[b] == ' ') ++b;
+        while (e > b && keys[e - 1] == ' ') --e;
+        if (b < e) {
+            const std::string key_name = keys.substr(b, e - b);
+            const SDL_Scancode sc = SDL_GetScancodeFromName(key_name.c_str());
+            if (sc == SDL_SCANCODE_UNKNOWN) {
+                SDL_Log("NeneInput: unknown key '%s' for action '%s'", key_name.c_str(), names_[id].c_str());
+            } else {
+                table_[sc] |= bit;
+                bound_[id].push_back(sc);
+            }
+        }
+        pos = end + 1;
+    }
+}
+
+void NeneInput::handle_event(const SDL_Event& ev) {
+    if (ev.type == SDL_EVENT_KEY_DOWN) {
+        if (ev.key.repeat) return;
+        const SDL_Scancode sc = ev.key.scancode;
+        if (sc < 0 || sc >= SDL_SCANCODE_COUNT) return;
+        if (std::find(down_.begin(), down_.end(), sc) == down_.end()) down_.push_back(sc);
+        down_events_ |= table_[sc];
+    } else if (ev.type == SDL_EVENT_KEY_UP) {
+        const SDL_Scancode sc = ev.key.scancode;
+        if (sc < 0 || sc >= SDL_SCANCODE_COUNT) return;
+        auto it = std::find(down_.begin(), down_.end(), sc);
+        if (it != down_.end()) {
+            *it = down_.back();
+            down_.pop_back();
+        }
+        up_events_ |= table_[sc];
+    }
+}
+
+void NeneInput::end_frame() {
+    const NeneActionMask prev = held_;
+    // 同じアクションに複数のキーがあってもよいように, 押されているキーから組み直す
+    held_ = 0;
+    for (SDL_Scancode sc : down_) held_ |= table_[sc];
+    // 押したまま同じアクションの別のキーを押しても pressed にはしない
+    pressed_ = (held_ | down_events_) & ~prev;
+    released_ = (prev & ~held_) | (up_events_ & ~held_);
+}
+
+void NeneInput::clear() {
+    down_.clear();
+    held_ = 0;
+    pressed_ = 0;
+    released_ = 0;
+    down_events_ = 0;
+    up_events_ = 0;
+}
+
+// NeneInputRecorder / NeneInputReplay
+namespace {
+constexpr char kRecMagic[5] = { 'N', 'N', 'R', 'E', 'C' };
+constexpr std::uint8_t kRecVersion = 1;
+enum : std::uint8_t { kRecFrames = 0, kRecActionName = 1 };
+
+void write_varint_(std::ostream& os, std::uint64_t v) {
+    while (v >= 0x80) {
+        os.put(static_cast<char>((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    os.put(static_cast<char>(v));
+}
+bool read_varint_(std::istream& is, std::uint64_t& out) {
+    out = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        const int c = is.get();
+        if (c == std::char_traits<char>::eof()) return false;
+        out |= static_cast<std::uint64_t>(c & 0x7f) << shift;
+        if ((c & 0x80) == 0) return true;
+    }
+    return false;
+}
+template <class T>
+void write_raw_(std::ostream& os, const T& v) {
+    os.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+template <class T>
+bool read_raw_(std::istream& is, T& v) {
+    return static_cast<bool>(is.read(reinterpret_cast<char*>(&v), sizeof(T)));
+}
+}
+
+NeneInputRecorder::NeneInputRecorder(const std::string& path, std::uint32_t seed, float fixed_dt)
+    : out_(path, std::ios::binary | std::ios::trunc) {
+    if (!out_) throw std::runtime_error("NeneInputRecorder: cannot open " + path);
+    out_.write(kRecMagic, sizeof(kRecMagic));
+    out_.put(static_cast<char>(kRecVersion));
+    write_raw_(out_, seed);
+    write_raw_(out_, fixed_dt);
+}
+
+NeneInputRecorder::~NeneInputRecorder() {
+    close();
+}
+
+void NeneInputRecorder::record(const NeneInput& input) {
+    if (!out_.is_open()) return;
+    // 新しく登録されたアクションの名前を先に書く
+    if (named_ < input.action_count()) {
+        flush_run_();
+        for (; named_ < input.action_count(); ++named_) {
+            const std::string& name = input.action_name(static_cast<NeneActionId>(named_));
+            out_.put(static_cast<char>(kRecActionName));
+            write_varint_(out_, named_);
+            write_varint_(out_, name.size());
+            out_.write(name.data(), static_cast<std::streamsize>(name.size()));
+        }
+    }
+    const NeneActionMask held = input.held_mask();
+    const NeneActionMask pressed = input.pressed_mask();
+    const NeneActionMask released = input.released_mask();
+    if (run_ > 0 && (held != held_ || pressed != pressed_ || released != released_)) flush_run_();
+    held_ = held;
+    pressed_ = pressed;
+    released_ = released;
+    ++run_;
+    ++frames_;
+}
+
+void NeneInputRecorder::flush_run_() {
+    if (run_ == 0) return;
+    out_.put(static_cast<char>(kRecFrames));
+    write_varint_(out_, run_);
+    write_varint_(out_, held_);
+    write_varint_(out_, pressed_);
+    write_varint_(out_, released_);
+    run_ = 0;
+}
+
+void NeneInputRecorder::close() {
+    if (!out_.is_open()) return;
+    flush_run_();
+    out_.close();
+}
+
+NeneInputReplay::NeneInputReplay(const std::string& path)
+    : in_(path, std::ios::binary) {
+    if (!in_) throw std::runtime_error("NeneInputReplay: cannot open " + path);
+    char magic[sizeof(kRecMagic)]{};
+    in_.read(magic, sizeof(magic));
+    const int version = in_.get();
+    if (!in_ || std::memcmp(magic, kRecMagic, sizeof(kRecMagic)) != 0 || version != kRecVersion) {
+        throw std::runtime_error("NeneInputReplay: not a recording (or unsupported version): " + path);
+    }
+    if (!read_raw_(in_, seed_) || !read_raw_(in_, fixed_dt_)) {
+        throw std::runtime_error("NeneInputReplay: truncated header: " + path);
+    }
+}
+
+bool NeneInputReplay::next(NeneInput& input) {
+    while (run_ == 0) {
+        const int tag = in_.get();
+        if (tag == std::char_traits<char>::eof()) return false;
+        if (tag == kRecActionName) {
+            std::uint64_t id = 0, len = 0;
+            if (!read_varint_(in_, id) || !read_varint_(in_, len)) return false;
+            std::string name(static_cast<std::size_t>(len), '\0');
+            if (!in_.read(name.data(), static_cast<std::streamsize>(len))) return false;
+            if (names_.size() <= id) names_.resize(static_cast<std::size_t>(id) + 1);
+            names_[static_cast<std::size_t>(id)] = std::move(name);
+        } else if (tag == kRecFrames) {
+            std::uint64_t held = 0, pressed = 0, released = 0;
+            if (!read_varint_(in_, run_) || !read_varint_(in_, held) ||
+                !read_varint_(in_, pressed) || !read_varint_(in_, released)) {
+                return false;
+            }
+            held_ = held;
+            pressed_ = pressed;
+            released_ = released;
+        } else {
+            throw std::runtime_error("NeneInputReplay: broken recording");
+        }
+    }
+    --run_;
+    ++frames_;
+    // 記録したときと今とでアクションの登録順が違っても名前で合わせる
+    input.set_frame(remap_(held_, input), remap_(pressed_, input), remap_(released_, input));
+    return true;
+}
+
+NeneActionMask NeneInputReplay::remap_(NeneActionMask recorded, NeneInput& input) {
+    NeneActionMask out = 0;
+    for (std::size_t i = 0; recorded != 0; ++i, recorded >>= 1) {
+        if ((recorded & 1u) == 0 || i >= names_.size() || names_[i].empty()) continue;
+        out |= NeneActionMask{ 1 } << input.action(names_[i]);
+    }
+    return out;
+}
+
+// NeneImageLoader
+NeneImageLoader::NeneImageLoader(SDL_Renderer* renderer, int worker_count)
+    : renderer_(renderer) {
+    if (!renderer_) {
+        throw std::runtime_error("NeneImageLoader: renderer is null");
+    }
+    // SDL3_image では IMG_Init / IMG_Quit は不要
+    // スレッドは最初の非同期読み込みで立てる（同期読み込みしか使わないなら立てない）
+    worker_count_ = worker_count < 1 ? 1 : worker_count;
+}
+
+// load_async（メインスレッド）から最初の1回だけ呼ぶ
+void NeneImageLoader::start_workers_() {
+    workers_.reserve(static_cast<std::size_t>(worker_count_));
+    for (int i = 0; i < worker_count_; ++i) {
+        workers_.emplace_back([this] { worker_main_(); });
+    }
+}
+
+NeneImageLoader::~NeneImageLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto& th : workers_) {
+        if (th.joinable()) th.join();
+    }
+    cache_.clear();
+    for (SDL_Texture* page : atlas_pages_) {
+        if (page) SDL_DestroyTexture(page);
+    }
+    atlas_pages_.clear();
+    sprites_.clear();
+    // SDL3_image では IMG_Quit も不要
+}
+
+// ワーカー: 画像ファイルを SDL_Surface にデコードするだけ（SDL_Renderer には触らない）
+void NeneImageLoader::worker_main_() {
+    for (;;) {
+        NeneTextureHandle slot;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_cv_.wait(lock, [this] { return stopping_ || !work_queue_.empty(); });
+            if (stopping_) return;
+            slot = std::move(work_queue_.front());
+            work_queue_.pop_front();
+            ++decoding_;
+        }
+        SDL_Surface* surf = IMG_Load(slot->path.c_str());
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (surf) {
+                slot->surface = surf;
+                slot->state = NeneAssetState::Decoded;
+            } else {
+                slot->error = SDL_GetError();
+                slot->state = NeneAssetState::Failed;
+            }
+            done_queue_.push_back(slot);
+            --decoding_;
+        }
+        done_cv_.notify_all();
+    }
+}
+
+void NeneImageLoader::upload_(NeneTextureSlot& slot) {
+    if (slot.state.load() != NeneAssetState::Decoded) return;
+    slot.bytes = static_cast<std::size_t>(slot.surface->w) * static_cast<std::size_t>(slot.surface->h) * 4u;
+    slot.texture = SDL_CreateTextureFromSurface(renderer_, slot.surface);
+    SDL_DestroySurface(slot.surface);
+    slot.surface = nullptr;
+    if (!slot.texture) {
+        slot.error = SDL_GetError();
+        slot.state = NeneAssetState::Failed;
+        slot.bytes = 0;
+        return;
+    }
+    slot.state = NeneAssetState::Ready;
+    cache_.set_bytes(slot.path, slot.bytes);
+}
+
+// 非同期で読み込み中のものを今すぐ使いたいとき（まだ順番待ちならこのスレッドでデコードする）
+void NeneImageLoader::finish_now_(const NeneTextureHandle& slot) {
+    bool decode_here = false;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = std::find(work_queue_.begin(), work_queue_.end(), slot);
+        if (it != work_queue_.end()) {
+            work_queue_.erase(it);
+            decode_here = true;
+        } else {
+            done_cv_.wait(lock, [&] { return slot->state.load() != NeneAssetState::Queued; });
+        }
+    }
+    if (decode_here) {
+        SDL_Surface* surf = IMG_Load(slot->path.c_str());
+        if (surf) {
+            slot->surface = surf;
+            slot->state = NeneAssetState::Decoded;
+        } else {
+            slot->error = SDL_GetError();
+            slot->state = NeneAssetState::Failed;
+        }
+    }
+    upload_(*slot);
+}
+
+SDL_Texture* NeneImageLoader::get_texture(const std::string& path) {
+    NeneTextureHandle slot = acquire_texture(path);
+    slot->pinned = true;
+    return slot->texture;
+}
+
+NeneTextureHandle NeneImageLoader::acquire_texture(const std::string& path) {
+    nene_require_serial("NeneImageLoader::acquire_texture");
+    NeneTextureHandle slot = cache_.find(path);
+    if (!slot) {
+        slot = std::make_shared<NeneTextureSlot>();
+        slot->path = path;
+        slot->texture = IMG_LoadTexture(renderer_, path.c_str());
+        if (!slot->texture) {
+            throw std::runtime_error(std::string("[NeneImageLoader] IMG_LoadTexture failed '")
+                                     + path + "': " + SDL_GetError());
+        }
+        float w = 0.0f, h = 0.0f;
+        SDL_GetTextureSize(slot->texture, &w, &h);
+        slot->bytes = static_cast<std::size_t>(w) * static_cast<std::size_t>(h) * 4u;
+        slot->state = NeneAssetState::Ready;
+        cache_.insert(path, slot);
+        cache_.trim();
+        return slot;
+    }
+    if (!slot->ready() && !slot->failed()) finish_now_(slot);
+    if (slot->failed()) {
+        throw std::runtime_error(std::string("[NeneImageLoader] IMG_LoadTexture failed '")
+                                 + path + "': " + slot->error);
+    }
+    return slot;
+}
+
+NeneTextureHandle NeneImageLoader::load_async(const std::string& path, const std::string& notify_to) {
+    nene_require_serial("NeneImageLoader::load_async");
+    if (NeneTextureHandle hit = cache_.find(path)) {
+        if (!notify_to.empty()) {
+            hit->notify.push_back(notify_to);
+            notify_slots_.push_back(hit); // 完了済みなら次の update で通知される
+        }
+        return hit;
+    }
+    auto slot = std::make_shared<NeneTextureSlot>();
+    slot->path = path;
+    if (!notify_to.empty()) {
+        slot->notify.push_back(notify_to);
+        notify_slots_.push_back(slot);
+    }
+    cache_.insert(path, slot);
+    if (workers_.empty()) start_workers_();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        work_queue_.push_back(slot);
+    }
+    work_cv_.notify_one();
+    return slot;
+}
+
+void NeneImageLoader::preload(const NeneAssetManifest& manifest, const std::string& notify_to, const std::string& tag) {
+    nene_require_serial("NeneImageLoader::preload");
+    PreloadGroup group;
+    group.notify_to = notify_to;
+    group.tag = tag;
+    group.items.reserve(manifest.textures.size());
+    for (const auto& path : manifest.textures) {
+        group.items.push_back(load_async(path));
+    }
+    groups_.push_back(std::move(group));
+}
+
+bool NeneImageLoader::is_loaded(const NeneAssetManifest& manifest) const {
+    for (const auto& path : manifest.textures) {
+        const NeneTextureSlot* slot = cache_.peek(path);
+        if (!slot || !slot->ready()) return false;
+    }
+    return true;
+}
+
+bool NeneImageLoader::idle() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return work_queue_.empty() && decoding_ == 0 && done_queue_.empty() && groups_.empty() && notify_slots_.empty();
+}
+
+void NeneImageLoader::update(NeneMailServer& mail_server, Uint64 budget_ns) {
+    nene_require_serial("NeneImageLoader::update");
+    const Uint64 start = SDL_GetTicksNS();
+    // アップロードは予算内で（最低1枚は進める）
+    for (bool first = true; ; first = false) {
+        if (!first && SDL_GetTicksNS() - start >= budget_ns) break;
+        NeneTextureHandle slot;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (done_queue_.empty()) break;
+            slot = std::move(done_queue_.front());
+            done_queue_.pop_front();
+        }
+        upload_(*slot); // get_texture で先に済んでいれば何もしない
+    }
+    // 待っているノードへ通知
+    for (std::size_t i = 0; i < notify_slots_.size(); ) {
+        NeneTextureSlot& slot = *notify_slots_[i];
+        const NeneAssetState st = slot.state.load();
+        if (st != NeneAssetState::Ready && st != NeneAssetState::Failed) { ++i; continue; }
+        const char* subject = (st == NeneAssetState::Ready) ? "texture_ready" : "texture_failed";
+        for (auto& to : slot.notify) mail_server.push(NeneMail(std::move(to), "asset_loader", subject, slot.path));
+        slot.notify.clear();
+        notify_slots_[i] = std::move(notify_slots_.back());
+        notify_slots_.pop_back();
+    }
+    // マニフェスト単位の完了通知
+    for (std::size_t i = 0; i < groups_.size(); ) {
+        auto& g = groups_[i];
+        bool done = true;
+        for (const auto& slot : g.items) {
+            if (!slot->ready() && !slot->failed()) { done = false; break; }
+        }
+        if (!done) { ++i; continue; }
+        if (g.notify_to.empty()) mail_server.push(NeneMail("asset_loader", "preload_done", g.tag));
+        else mail_server.push(NeneMail(g.notify_to, "asset_loader", "preload_done", g.tag));
+        groups_.erase(groups_.begin() + static_cast<std::ptrdiff_t>(i));
+    }
+    // 手放されたテクスチャを予算まで追い出す
+    cache_.trim();
+}
+
+void NeneImageLoader::register_sprite(const std::string& name, const std::string& sheet_path, SDL_FRect src) {
+    nene_require_serial("NeneImageLoader::register_sprite");
+    sprites_[name] = NeneSprite{ get_texture(sheet_path), src };
+}
+
+int NeneImageLoader::build_atlas(const std::vector<NeneAtlasEntry>& entries, int page_size, int padding) {
+    nene_require_serial("NeneImageLoader::build_atlas");
+    // デコード
+    std::vector<SDL_Surface*> surfs(entries.size(), nullptr);
+    std::vector<NenePackItem> items(entries.size());
+    auto release = [&] {
+        for (SDL_Surface* s : surfs) if (s) SDL_DestroySurface(s);
+    };
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        surfs[i] = IMG_Load(entries[i].path.c_str());
+        if (!surfs[i]) {
+            const std::string err = SDL_GetError();
+            release();
+            throw std::runtime_error("[NeneImageLoader] IMG_Load failed '" + entries[i].path + "': " + err);
+        }
+        items[i].w = surfs[i]->w;
+        items[i].h = surfs[i]->h;
+    }
+    // 配置
+    const int pages = nene_pack_rects(items, page_size, page_size, padding);
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        if (items[i].page < 0) {
+            release();
+            throw std::runtime_error("[NeneImageLoader] build_atlas: image too large '" + entries[i].path + "'");
+        }
+    }
+    // ページごとに転写してテクスチャ化
+    for (int p = 0; p < pages; ++p) {
+        SDL_Surface* page = SDL_CreateSurface(page_size, page_size, SDL_PIXELFORMAT_RGBA32);
+        if (!page) {
+            release();
+            throw std::runtime_error(std::string("[NeneImageLoader] SDL_CreateSurface failed: ") + SDL_GetError());
+        }
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            if (items[i].page != p) continue;
+            SDL_SetSurfaceBlendMode(surfs[i], SDL_BLENDMODE_NONE); // アルファもそのまま写す
+            const SDL_Rect dst{ items[i].x, items[i].y, items[i].w, items[i].h };
+            SDL_BlitSurface(surfs[i], nullptr, page, &dst);
+        }
+        SDL_Texture* tex = SDL_CreateTextureFromSurface(renderer_, page);
+        SDL_DestroySurface(page);
+        if (!tex) {
+            release();
+            throw std::runtime_error(std::string("[NeneImageLoader] SDL_CreateTextureFromSurface failed: ") + SDL_GetError());
+        }
+        atlas_pages_.push_back(tex);
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            if (items[i].page != p) continue;
+            sprites_[entries[i].name] = NeneSprite{
+                tex,
+                SDL_FRect{ static_cast<float>(items[i].x), static_cast<float>(items[i].y),
+                           static_cast<float>(items[i].w), static_cast<float>(items[i].h) }
+            };
+        }
+    }
+    release();
+    return pages;
+}
+
+NeneSprite NeneImageLoader::sprite(const std::string& name) const {
+    auto it = sprites_.find(name);
+    if (it == sprites_.end()) {
+        throw std::runtime_error("[NeneImageLoader] unknown sprite '" + name + "'");
+    }
+    return it->second;
 }